@@ -14,6 +14,11 @@ local zombie_count = 0
 local spawn_timer = 0
 local new_spawn_flash = 0.0
 
+-- Line of sight: one batched ray per zombie towards the player, submitted
+-- together and read back after the next physics step
+local los_batch   = QueryBatch.new()
+local los_zombies = {}   -- zombie of each query in the batch
+
 -- Tuning
 local ZOMBIE_BASE_SPEED  = 2.8
 local ZOMBIE_SPEED_INC   = 0.5
@@ -24,7 +29,7 @@ local CATCH_RANGE        = 1.8
 local MAP_EDGE           = 58.0
 local ZOMBIE_SCALE       = 0.01   -- Mixamo GLB geometry is in cm
 
--- Capsule dims — must match createCapsuleRigidBody call below
+-- Capsule dims — must match createCharacterController call below
 local CAPSULE_RADIUS     = 0.3
 local CAPSULE_HEIGHT     = 1.0
 -- Distance from capsule centre to the bottom; used to place visual root at feet level
@@ -72,26 +77,32 @@ local function dist2d(a, b)
     return math.sqrt(dx * dx + dz * dz)
 end
 
-local function spawn_zombie(scene)
-    zombie_count = zombie_count + 1
-    local speed = ZOMBIE_BASE_SPEED + (zombie_count - 1) * ZOMBIE_SPEED_INC
-    local pos   = edge_spawn_pos()
-
+-- nil when the engine has no room for another skinned mesh
+local function create_zombie_mesh(scene, anim_speed)
     local mesh = scene:create_skinned_object("assets/models/zombie.glb")
-    mesh:setPosition(pos)
+    if mesh == nil then return nil end
+    mesh:setPosition(edge_spawn_pos())
     mesh:setScale(ZOMBIE_SCALE, ZOMBIE_SCALE, ZOMBIE_SCALE)
     mesh:playAnimation(0)
     mesh:setLooping(true)
-    mesh:setAnimSpeed(0.7 + (zombie_count - 1) * 0.1)
-    mesh:createCapsuleRigidBody(70.0, CAPSULE_RADIUS, CAPSULE_HEIGHT)
-    mesh:setFriction(0.0)
-    mesh:setDamping(0.0, 0.0)
+    mesh:setAnimSpeed(anim_speed)
+    mesh:createCharacterController(CAPSULE_RADIUS, CAPSULE_HEIGHT)
     scene:registerPhysics(mesh)
+    return mesh
+end
+
+local function spawn_zombie(scene)
+    local speed = ZOMBIE_BASE_SPEED + zombie_count * ZOMBIE_SPEED_INC
+    local anim_speed = 0.7 + zombie_count * 0.1
+    local mesh = create_zombie_mesh(scene, anim_speed)
+    if mesh == nil then return end
+    zombie_count = zombie_count + 1
 
     table.insert(zombies, {
         mesh          = mesh,
         speed         = speed,
         patrol_target = rand_patrol_pos(),
+        sees_player   = true,
     })
 
     new_spawn_flash = 3.0
@@ -189,6 +200,25 @@ function draw(scene, window)
         ui_nearest_dist = 999.0
         ui_spawn_timer  = spawn_timer
 
+        -- Rocks give cover: a zombie only chases while its ray reaches the
+        -- player (or nothing, e.g. the player is mid-jump)
+        if los_batch:isReady() then
+            local bodies = los_batch:bodies()
+            local player = scene.camera:getBodyId()
+            for i, z in ipairs(los_zombies) do
+                z.sees_player = bodies[i] == -1 or bodies[i] == player
+            end
+        end
+        if not los_batch:isPending() and #zombies > 0 then
+            los_batch:clear()
+            los_zombies = {}
+            for _, z in ipairs(zombies) do
+                los_batch:addRay(z.mesh:getPhysicsPosition(), camPos, z.mesh:getBodyId())
+                table.insert(los_zombies, z)
+            end
+            scene:submit_queries(los_batch)
+        end
+
         -- Update each zombie
         -- (heartbeat updated after loop once ui_nearest_dist is known)
         for _, z in ipairs(zombies) do
@@ -226,7 +256,7 @@ function draw(scene, window)
 
             -- Choose movement target: chase or patrol
             local target
-            if d < DETECTION_RANGE then
+            if d < DETECTION_RANGE and z.sees_player then
                 target = camPos
             else
                 if dist2d(zpos, z.patrol_target) < 2.0 then
@@ -235,15 +265,14 @@ function draw(scene, window)
                 target = z.patrol_target
             end
 
-            -- Drive horizontal velocity; preserve vertical (gravity) from physics
+            -- Drive horizontal velocity; the controller handles gravity, steps and slopes
             local mdx = target.x - zpos.x
             local mdz = target.z - zpos.z
             local mlen = math.sqrt(mdx * mdx + mdz * mdz)
             if mlen > 0.1 then
                 mdx = mdx / mlen
                 mdz = mdz / mlen
-                local curVel = z.mesh:getLinearVelocity()
-                z.mesh:setLinearVelocity(vec3.new(mdx * z.speed, curVel.y, mdz * z.speed))
+                z.mesh:setWalkVelocity(vec3.new(mdx * z.speed, 0.0, mdz * z.speed))
 
                 -- Rotate zombie to face direction of travel.
                 -- If zombies face the wrong way, add math.pi to the angle below.
@@ -24,6 +24,12 @@ layout(location = 14) in vec4 inFragPosLightSpace;
 
 layout(location = 0) out vec4 FragColor;
 
+// Pipeline variant switches, see ShaderVariants.hpp. Disabled features are
+// stripped at pipeline creation instead of branching per fragment.
+layout(constant_id = 0) const bool NORMAL_MAP = true;
+layout(constant_id = 1) const bool MR_MAP = true;
+layout(constant_id = 2) const int PCF_RADIUS = 1;
+
 const float PI = 3.14159265359;
 
 vec3 aces(vec3 x) {
@@ -68,12 +74,13 @@ float ShadowCalculation(vec4 fragPosLightSpace) {
 
     float shadow = 0.0;
     vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
-    for(int x = -1; x <= 1; ++x) {
-        for(int y = -1; y <= 1; ++y) {
+    for(int x = -PCF_RADIUS; x <= PCF_RADIUS; ++x) {
+        for(int y = -PCF_RADIUS; y <= PCF_RADIUS; ++y) {
             shadow += texture(shadowMap, vec3(projCoords.xy + vec2(x, y) * texelSize, projCoords.z));
         }    
     }
-    shadow /= 9.0;
+    float taps = float(PCF_RADIUS * 2 + 1);
+    shadow /= taps * taps;
     
     return 1.0 - shadow;
 }
@@ -86,7 +93,8 @@ void main() {
 
     // Normal mapping
     vec3 N;
-    if (f_normalID >= 0) {
+    // meshes mixing mapped and unmapped primitives still need the per-vertex check
+    if (NORMAL_MAP && f_normalID >= 0) {
         vec3 normalMap = textureIndex(0, textures, samp, inTexCoords, f_normalID).rgb;
         normalMap = normalize(normalMap * 2.0 - 1.0);
         N = normalize(inTBN * normalMap);
@@ -119,7 +127,7 @@ void main() {
 
     float shadow = ShadowCalculation(inFragPosLightSpace);
 
-    if (f_mrID >= 0) {
+    if (MR_MAP && f_mrID >= 0) {
         // PBR Path (Metallic-Roughness Map present)
         vec4 mrSample = textureIndex(0, textures, samp, inTexCoords, f_mrID);
         float roughness = clamp(mrSample.g, 0.05, 1.0);
@@ -11,7 +11,6 @@ layout(binding = 0) uniform UniformBufferObject {
 
 layout( push_constant ) uniform constant {
     mat4 model;
-    int enableNormal;
     float metallic;
     float roughness;
 } PushConstants;
@@ -82,5 +81,5 @@ void main() {
     f_roughness = PushConstants.roughness;
     viewPos = ubo.camPos;
 
-    f_normalID = (PushConstants.enableNormal == 1) ? normalID : -1;
+    f_normalID = normalID;
 }
@@ -11,7 +11,6 @@ layout(binding = 0) uniform UniformBufferObject {
 
 layout( push_constant ) uniform constant {
     mat4 model;
-    int enableNormal;
     float metallic;
     float roughness;
 } PushConstants;
@@ -0,0 +1,20 @@
+# Turns a compiled .spv into a header with the words as a constexpr array.
+# Usage: cmake -DINPUT=<file.spv> -DOUTPUT=<file.h> -DSYMBOL=<name> -P EmbedSpirv.cmake
+
+file(READ "${INPUT}" SPIRV_HEX HEX)
+string(LENGTH "${SPIRV_HEX}" SPIRV_HEX_LENGTH)
+math(EXPR SPIRV_WORD_COUNT "${SPIRV_HEX_LENGTH} / 8")
+
+# SPIR-V is a stream of little-endian 32-bit words
+string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1u," SPIRV_WORDS "${SPIRV_HEX}")
+string(REGEX REPLACE "(([^,]*,){8})" "\\1\n    " SPIRV_WORDS "${SPIRV_WORDS}")
+
+file(WRITE "${OUTPUT}"
+"// generated from ${INPUT}, do not edit
+#pragma once
+#include <cstdint>
+
+inline constexpr uint32_t ${SYMBOL}[${SPIRV_WORD_COUNT}] = {
+    ${SPIRV_WORDS}
+};
+")
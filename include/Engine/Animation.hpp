@@ -16,43 +16,57 @@ struct KeyFrame {
 
 struct Animation {
     std::vector<KeyFrame> keyframes;
-    double time;
-    bool finished;
+    double time = 0.0;
+    bool finished = false;
     glm::vec3 position;
     glm::quat rotation;
+    // keyframe the last tick landed in; time only moves forward, so the
+    // next tick usually starts right there instead of searching
+    size_t currentIndex = 0;
 };
 
 void tickAnimation(double deltaTime, Animation *animation) {
     animation->time += deltaTime;
 
-    auto nextIt = std::lower_bound(
-        animation->keyframes.begin(),
-        animation->keyframes.end(),
-        animation->time,
-        [](const KeyFrame& frame, float time) {return frame.timeStamp < time;}
-    );
-    int nextIndex = std::distance(animation->keyframes.begin(), nextIt);
-    int currentIndex = nextIndex - 1;
+    const std::vector<KeyFrame>& keyframes = animation->keyframes;
+    if (keyframes.empty()) return;
+    size_t last = keyframes.size() - 1;
 
-    float timeStamp = animation->keyframes[currentIndex].timeStamp;
-    KeyFrame nextKeyFrame = animation->keyframes[nextIndex];
-    float nextTimeStamp = nextKeyFrame.timeStamp;
-    float timeDiff = nextTimeStamp - timeStamp;
-    float res;
-    float t;
+    // time was reset or moved backwards, search again from the start
+    size_t currentIndex = animation->currentIndex;
+    if (currentIndex > last || keyframes[currentIndex].timeStamp > animation->time) {
+        currentIndex = 0;
+    }
+    while (currentIndex < last && keyframes[currentIndex + 1].timeStamp <= animation->time) {
+        currentIndex++;
+    }
+    animation->currentIndex = currentIndex;
+
+    if (currentIndex == last) {
+        animation->position = keyframes[last].position;
+        animation->rotation = keyframes[last].rotation;
+        animation->finished = true;
+        return;
+    }
+    animation->finished = false;
+
+    const KeyFrame& keyFrame = keyframes[currentIndex];
+    const KeyFrame& nextKeyFrame = keyframes[currentIndex + 1];
+    float timeDiff = nextKeyFrame.timeStamp - keyFrame.timeStamp;
+    float t = 0.0f;
     if (timeDiff > 0) {
-        t = (animation->time - timeStamp) / timeDiff;
+        t = glm::clamp((float)(animation->time - keyFrame.timeStamp) / timeDiff, 0.0f, 1.0f);
     }
 
-    //printf("Animation: Start: %f, End: %f, Progress: %f\n", timeStamp, nextTimeStamp, t);
+    //printf("Animation: Start: %f, End: %f, Progress: %f\n", keyFrame.timeStamp, nextKeyFrame.timeStamp, t);
 
-    animation->position = glm::mix(animation->keyframes[currentIndex].position, nextKeyFrame.position, t);
-    animation->rotation = glm::slerp(animation->keyframes[currentIndex].rotation, nextKeyFrame.rotation, t);
+    animation->position = glm::mix(keyFrame.position, nextKeyFrame.position, t);
+    animation->rotation = glm::slerp(keyFrame.rotation, nextKeyFrame.rotation, t);
 }
 
 void testAnimation() {
     Animation anim;
-    //anim.currentIndex = 0;
+    anim.currentIndex = 0;
     
     anim.keyframes.push_back({
         glm::vec3(0.0, 0.0, 0.0),
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "btBulletDynamicsCommon.h"
+
+// Recycled storage for rigid bodies and their motion states, so spawning
+// and despawning never hits the heap once a pool has warmed up. Bodies are
+// built in place in a free block and torn down in place on destroy; the
+// block goes back on the free list.
+//
+// Every btRigidBody in the engine comes from here. Call create/destroy from
+// any thread, but only for bodies no world holds.
+namespace Physics {
+    class BodyPool {
+        struct Block {
+            alignas(16) unsigned char body[sizeof(btRigidBody)];
+            alignas(16) unsigned char motionState[sizeof(btDefaultMotionState)];
+        };
+
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Block>> blocks;
+        std::vector<Block *> freeBlocks;
+
+        static BodyPool &instance() {
+            static BodyPool pool;
+            return pool;
+        }
+
+        Block *acquire() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (freeBlocks.empty()) {
+                blocks.push_back(std::make_unique<Block>());
+                return blocks.back().get();
+            }
+            Block *block = freeBlocks.back();
+            freeBlocks.pop_back();
+            return block;
+        }
+
+    public:
+        // Same as new btRigidBody with a btDefaultMotionState at transform
+        static btRigidBody *create(btScalar mass, btCollisionShape *shape, const btTransform &transform,
+                                   const btVector3 &localInertia = btVector3(0, 0, 0)) {
+            Block *block = instance().acquire();
+            btDefaultMotionState *motionState = new (block->motionState) btDefaultMotionState(transform);
+            btRigidBody::btRigidBodyConstructionInfo info(mass, motionState, shape, localInertia);
+            return new (block->body) btRigidBody(info);
+        }
+
+        static void destroy(btRigidBody *body) {
+            if (!body) return;
+            // the body sits at the start of its block
+            Block *block = reinterpret_cast<Block *>(body);
+            btMotionState *motionState = body->getMotionState();
+            body->~btRigidBody();
+            if (motionState) motionState->~btMotionState();
+
+            BodyPool &pool = instance();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            pool.freeBlocks.push_back(block);
+        }
+
+        static size_t capacity() {
+            BodyPool &pool = instance();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            return pool.blocks.size();
+        }
+    };
+
+    // What an engine body is configured with before it joins a world, so a
+    // parked body (PhysicsManager) can stand in for a freshly built one with
+    // the same shape and kind
+    struct BodySetup {
+        btTransform transform;
+        btScalar mass = 0;
+        btVector3 localInertia{0, 0, 0};
+        int collisionFlags = 0;
+        int activationState = ACTIVE_TAG;
+        btScalar friction = 0.5f;
+        btScalar rollingFriction = 0;
+        btScalar restitution = 0;
+        btScalar linearDamping = 0;
+        btScalar angularDamping = 0;
+        btVector3 linearFactor{1, 1, 1};
+        btVector3 angularFactor{1, 1, 1};
+        btScalar linearSleepingThreshold = 0;
+        btScalar angularSleepingThreshold = 0;
+        btScalar ccdMotionThreshold = 0;
+        btScalar ccdSweptSphereRadius = 0;
+
+        static BodySetup of(const btRigidBody &body) {
+            BodySetup setup;
+            setup.transform = body.getWorldTransform();
+            setup.mass = body.getInvMass() > 0 ? 1.0f / body.getInvMass() : 0;
+            setup.localInertia = body.getLocalInertia();
+            setup.collisionFlags = body.getCollisionFlags();
+            setup.activationState = body.getActivationState();
+            setup.friction = body.getFriction();
+            setup.rollingFriction = body.getRollingFriction();
+            setup.restitution = body.getRestitution();
+            setup.linearDamping = body.getLinearDamping();
+            setup.angularDamping = body.getAngularDamping();
+            setup.linearFactor = body.getLinearFactor();
+            setup.angularFactor = body.getAngularFactor();
+            setup.linearSleepingThreshold = body.getLinearSleepingThreshold();
+            setup.angularSleepingThreshold = body.getAngularSleepingThreshold();
+            setup.ccdMotionThreshold = body.getCcdMotionThreshold();
+            setup.ccdSweptSphereRadius = body.getCcdSweptSphereRadius();
+            return setup;
+        }
+
+        // Leaves body as if it had just been built with this setup; its
+        // gravity and broadphase proxy are the world's business
+        void applyTo(btRigidBody *body) const {
+            body->setCollisionFlags(collisionFlags);
+            body->setMassProps(mass, localInertia);
+            body->updateInertiaTensor();
+            body->setWorldTransform(transform);
+            body->setInterpolationWorldTransform(transform);
+            if (body->getMotionState()) body->getMotionState()->setWorldTransform(transform);
+
+            body->setLinearVelocity(btVector3(0, 0, 0));
+            body->setAngularVelocity(btVector3(0, 0, 0));
+            body->setInterpolationLinearVelocity(btVector3(0, 0, 0));
+            body->setInterpolationAngularVelocity(btVector3(0, 0, 0));
+            body->clearForces();
+
+            body->setFriction(friction);
+            body->setRollingFriction(rollingFriction);
+            body->setRestitution(restitution);
+            body->setDamping(linearDamping, angularDamping);
+            body->setLinearFactor(linearFactor);
+            body->setAngularFactor(angularFactor);
+            body->setSleepingThresholds(linearSleepingThreshold, angularSleepingThreshold);
+            body->setCcdMotionThreshold(ccdMotionThreshold);
+            body->setCcdSweptSphereRadius(ccdSweptSphereRadius);
+
+            body->forceActivationState(activationState);
+            body->setDeactivationTime(0);
+        }
+    };
+}
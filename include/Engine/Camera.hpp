@@ -20,6 +20,9 @@
 #include "config.h"
 #include "Engine.hpp"
 #include "FrustumCull.hpp"
+#include "PhysicsState.hpp"
+#include "BodyPool.hpp"
+#include "CharacterController.hpp"
 
 class Camera {
 private:
@@ -39,7 +42,9 @@ public:
 
     }
 
-    btRigidBody* rigidBody;
+    // rigidBody is the controller's kinematic capsule
+    std::shared_ptr<Physics::CharacterController> controller;
+    btRigidBody* rigidBody = nullptr;
     bool grounded = true;
     
     // Getters
@@ -219,8 +224,15 @@ public:
         updateViewMatrix();
         return viewMatrix;
     }
+    // as of the last physics step
     glm::vec3 getVelocity() {
-        return physicsToWorld(rigidBody->getLinearVelocity());
+        const Physics::BodyState *state = Physics::state(rigidBody);
+        return state ? state->linearVelocity : glm::vec3(0.0f);
+    }
+
+    // Identifies the camera body in physics query results
+    int getBodyId() const {
+        return rigidBody ? rigidBody->getUserIndex() : -1;
     }
 
     Frustum getFrustum() {
@@ -228,60 +240,41 @@ public:
     }
 
     void createRigidBody() {
-        btCollisionShape* bodyShape = new btCapsuleShape(0.5, 1.0);
-        btTransform bodyTransform;
-        bodyTransform.setIdentity();
-        bodyTransform.setOrigin(btVector3(position.x, position.y, position.z));
-
-        float mass = 70.0;
-        btVector3 localInertia(0, 0, 0);
-        bodyShape->calculateLocalInertia(mass, localInertia);
-        localInertia *= 0.1f;
-
-        btDefaultMotionState* motionState = new btDefaultMotionState(bodyTransform);
-
-        bodyShape->setMargin(0.001);
-
-        btRigidBody* meshBody = new btRigidBody(
-            btRigidBody::btRigidBodyConstructionInfo(
-                mass, motionState, bodyShape, localInertia
-            )
-        );
-
-        meshBody->setFriction(0.0f);
-        meshBody->setRestitution(0.0f);
-        meshBody->setAngularFactor(btVector3(0,0,0));
-        meshBody->setCollisionFlags(meshBody->getCollisionFlags() | btCollisionObject::CF_DISABLE_VISUALIZE_OBJECT);
+        Physics::CharacterSettings settings;
+        settings.radius = 0.5f;
+        settings.height = 1.0f;
 
-        rigidBody = meshBody;
+        controller = std::make_shared<Physics::CharacterController>(settings, btVector3(position.x, position.y, position.z));
+        rigidBody = controller->body;
+        rigidBody->setCollisionFlags(rigidBody->getCollisionFlags() | btCollisionObject::CF_DISABLE_VISUALIZE_OBJECT);
     }
-    void isGrounded(std::shared_ptr<btDynamicsWorld> world) {
-        btVector3 from = rigidBody->getWorldTransform().getOrigin();
-        btVector3 to = from - btVector3(0, 1.0 + (0.1), 0);
-        
-        btCollisionWorld::ClosestRayResultCallback rayCallback(from, to);
-        
-        // Perform raycast
-        world->rayTest(from, to, rayCallback);
-
-        grounded = rayCallback.hasHit();
+    // After the physics world let go of it
+    void destroyRigidBody() {
+        Physics::BodyPool::destroy(rigidBody);
+        rigidBody = nullptr;
+        controller.reset();
     }
     float getVelX() {
-        return rigidBody->getLinearVelocity().getX();
+        return getVelocity().x;
     }
     float getVelY() {
-        return rigidBody->getLinearVelocity().getY();
+        return getVelocity().y;
     }
     float getVelZ() {
-        return rigidBody->getLinearVelocity().getZ();
+        return getVelocity().z;
+    }
+
+    // Teleports the body and stops it, before the next physics step
+    void resetBody(const btTransform &transform) {
+        controller->teleport(transform.getOrigin());
     }
 
     bool isVisible(btRigidBody* body) {
-        btVector3 AA;
-        btVector3 BB;
-        body->getAabb(AA, BB);
-        glm::vec3 min = glm::vec3(AA.getX(), AA.getY(), AA.getZ()) / glm::vec3(100.0);
-        glm::vec3 max = glm::vec3(BB.getX(), BB.getY(), BB.getZ()) / glm::vec3(100.0);
+        const Physics::BodyState *state = Physics::state(body);
+        if (!state) return true; // not stepped yet
+
+        glm::vec3 min = state->aabbMin / glm::vec3(100.0);
+        glm::vec3 max = state->aabbMax / glm::vec3(100.0);
 
         return frustum.IsBoxVisible(min, max);
     }
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+
+#include "btBulletDynamicsCommon.h"
+
+#include "config.h"
+#include "Engine/BodyPool.hpp"
+#include "Engine/PhysicsQuery.hpp"
+#include "Engine/PhysicsState.hpp"
+#include "Engine/ShapeCache.hpp"
+
+// Kinematic capsule walker for the player and NPCs. Instead of pushing a
+// dynamic body around with velocities (and making the solver resolve every
+// footstep contact), each fixed step moves the capsule with a handful of
+// sweeps:
+//
+//   step up    lift by stepHeight when grounded, so ledges get climbed
+//   walk       collide and slide along what the sweep hits, up to three
+//              times; surfaces steeper than maxSlope act as walls
+//   step down  come back down by the lift plus snapDistance, sticking to
+//              walkable ground on slopes and stairs; otherwise fall
+//
+// The body is a kinematic rigid body in the world, so dynamic bodies bump
+// off it and queries see it. PhysicsManager runs every controller's sweeps
+// in parallel before each step, then moves the bodies.
+namespace Physics {
+    struct CharacterSettings {
+        btScalar radius = 0.3f;
+        btScalar height = 1.0f;       // cylinder part, Y up
+        btScalar stepHeight = 0.35f;
+        btScalar maxSlope = 0.87f;    // radians, about 50 degrees
+        btScalar snapDistance = 0.25f;
+        btScalar gravity = 9.81f;
+        btScalar skin = 0.02f;        // gap kept to surfaces so sweeps never start inside them
+    };
+
+    class CharacterController : public std::enable_shared_from_this<CharacterController> {
+    public:
+        // Set on the main thread before registration, physics thread after
+        CharacterSettings settings;
+        btRigidBody *body = nullptr;
+
+        // Physics thread state
+        btVector3 walkVelocity{0, 0, 0};
+        btScalar verticalVelocity = 0;
+        bool grounded = false;
+
+        CharacterController(const CharacterSettings &settings, const btVector3 &position) : settings(settings) {
+            btTransform transform;
+            transform.setIdentity();
+            transform.setOrigin(position);
+
+            body = BodyPool::create(0.0f, ShapeCache::capsule(settings.radius, settings.height, 0.001f), transform);
+            body->setCollisionFlags(body->getCollisionFlags() | btCollisionObject::CF_KINEMATIC_OBJECT);
+            body->setFriction(0.0f);
+            body->setRestitution(0.0f);
+            // moved every step by the controller, never by the solver
+            body->forceActivationState(DISABLE_DEACTIVATION);
+        }
+
+        // The body itself goes back to the BodyPool with its owner
+        CharacterController(const CharacterController &) = delete;
+        CharacterController &operator=(const CharacterController &) = delete;
+
+        // Queued like body setters: run before the next step. Velocities are
+        // horizontal, world units per second.
+        void setWalkVelocity(const btVector3 &velocity) {
+            auto self = shared_from_this();
+            btVector3 horizontal(velocity.getX(), 0, velocity.getZ());
+            enqueue(body, [self, horizontal] { self->walkVelocity = horizontal; });
+        }
+
+        void jump(btScalar speed) {
+            auto self = shared_from_this();
+            enqueue(body, [self, speed] {
+                self->verticalVelocity = speed;
+                self->grounded = false;
+            });
+        }
+
+        void teleport(const btVector3 &position) {
+            auto self = shared_from_this();
+            enqueue(body, [self, position] { self->place(position); });
+        }
+
+        // Physics thread. New capsule position after dt; updates only this
+        // controller's own state, so controllers can run concurrently.
+        btVector3 computeMove(btCollisionWorld *world, btScalar dt) {
+            const btVector3 up(0, 1, 0);
+            const btScalar minGroundUp = btCos(settings.maxSlope);
+            const btConvexShape *shape = static_cast<const btConvexShape *>(body->getCollisionShape());
+            btVector3 position = body->getWorldTransform().getOrigin();
+
+            // returns how far it got along delta, 0..1 of its length
+            auto cast = [&](const btVector3 &delta, SweepHit &hit) {
+                btScalar length = delta.length();
+                if (length <= SIMD_EPSILON) return btScalar(1);
+                hit = sweep(world, shape, at(position), at(position + delta), [this](const btCollisionObject *object) {
+                    return object == body || (object->getCollisionFlags() & btCollisionObject::CF_NO_CONTACT_RESPONSE);
+                });
+                if (!hit.hit) return btScalar(1);
+                return std::max(btScalar(0), hit.fraction * length - settings.skin) / length;
+            };
+            SweepHit hit;
+
+            btVector3 move = walkVelocity * dt;
+
+            btScalar lifted = 0;
+            if (grounded && settings.stepHeight > 0 && !move.fuzzyZero()) {
+                lifted = settings.stepHeight * cast(up * settings.stepHeight, hit);
+                position += up * lifted;
+            }
+
+            for (int i = 0; i < 3 && !move.fuzzyZero(); i++) {
+                hit = SweepHit();
+                btScalar travelled = cast(move, hit);
+                position += move * travelled;
+                if (!hit.hit) break;
+
+                btVector3 normal = hit.normal;
+                if (normal.dot(up) < minGroundUp) {
+                    // too steep to walk up: slide along it as a wall
+                    normal.setY(0);
+                    if (normal.fuzzyZero()) break;
+                    normal.normalize();
+                }
+                btVector3 remaining = move * (1 - travelled);
+                move = remaining - normal * remaining.dot(normal);
+            }
+
+            if (verticalVelocity > 0) {
+                hit = SweepHit();
+                btVector3 rise = up * (verticalVelocity * dt);
+                position += rise * cast(rise, hit);
+                if (hit.hit) verticalVelocity = 0; // head hit something
+                verticalVelocity -= settings.gravity * dt;
+                grounded = false;
+            } else {
+                btScalar fall = -verticalVelocity * dt;
+                btScalar reach = lifted + fall + (grounded ? settings.snapDistance : 0);
+                hit = SweepHit();
+                btScalar travelled = cast(-up * reach, hit);
+
+                if (hit.hit) {
+                    position -= up * (reach * travelled);
+                    grounded = hit.normal.dot(up) >= minGroundUp;
+                } else {
+                    // nothing underfoot within reach: undo the lift and fall
+                    position -= up * (lifted + fall);
+                    grounded = false;
+                }
+                if (grounded)
+                    verticalVelocity = 0;
+                else
+                    verticalVelocity -= settings.gravity * dt;
+            }
+
+            if (position.getY() < PHYSICS_KILL_Y) {
+                position = btVector3(0.0, 5.0, 0.0);
+                verticalVelocity = 0;
+            }
+            return position;
+        }
+
+        // Physics thread, after every controller's computeMove. Bullet takes
+        // the new pose from the motion state during the step and derives the
+        // body's velocity from it.
+        void applyMove(const btVector3 &position) {
+            btTransform transform = body->getWorldTransform();
+            transform.setOrigin(position);
+            body->getMotionState()->setWorldTransform(transform);
+        }
+
+    private:
+        static btTransform at(const btVector3 &origin) {
+            btTransform transform;
+            transform.setIdentity();
+            transform.setOrigin(origin);
+            return transform;
+        }
+
+        // Jumps there without a velocity spike
+        void place(const btVector3 &position) {
+            btTransform transform = body->getWorldTransform();
+            transform.setOrigin(position);
+            body->setWorldTransform(transform);
+            body->setInterpolationWorldTransform(transform);
+            body->getMotionState()->setWorldTransform(transform);
+            verticalVelocity = 0;
+            grounded = false;
+        }
+    };
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#include "btBulletDynamicsCommon.h"
+#include "LinearMath/btConvexHull.h"
+
+#include "config.h"
+#include "Engine/Vertex.hpp"
+
+// Offline-quality convex hulls for collision, run once per model and cached
+// by ShapeCache.
+//
+// buildHull runs Bullet's HullLibrary (incremental farthest-point hull, the
+// same idea as quickhull) over every vertex and stops at maxVertices, so
+// the result covers the whole mesh with a bounded point count.
+//
+// decompose splits a concave mesh into a few such hulls, V-HACD style but
+// much simpler: a part is split by an axis plane through its triangle
+// centroids, choosing the axis whose two halves have the smallest total
+// hull volume, and stops once splitting no longer shrinks that volume by
+// more than `concavity` (it is convex enough) or the part budget runs out.
+// Biggest parts are split first.
+namespace Convex {
+    struct Hull {
+        std::vector<btVector3> points;
+        btScalar volume = 0;
+    };
+
+    inline Hull buildHull(const std::vector<btVector3> &points, unsigned maxVertices = HULL_MAX_VERTICES) {
+        Hull hull;
+        if (points.size() < 4) {
+            hull.points = points;
+            return hull;
+        }
+
+        HullDesc desc(QF_TRIANGLES, (unsigned)points.size(), points.data());
+        desc.mMaxVertices = std::max(4u, maxVertices);
+
+        HullLibrary library;
+        HullResult result;
+        if (library.CreateConvexHull(desc, result) != QE_OK || result.mNumOutputVertices < 4) {
+            // flat or degenerate: the points are still usable as a hull
+            hull.points = points;
+            return hull;
+        }
+
+        btVector3 center(0, 0, 0);
+        hull.points.resize(result.mNumOutputVertices);
+        for (unsigned i = 0; i < result.mNumOutputVertices; i++) {
+            hull.points[i] = result.m_OutputVertices[i];
+            center += hull.points[i];
+        }
+        center /= (btScalar)result.mNumOutputVertices;
+
+        // sum of tetrahedra from the center to each face
+        for (unsigned i = 0; i + 2 < result.mNumIndices; i += 3) {
+            const btVector3 &a = result.m_OutputVertices[result.m_Indices[i]];
+            const btVector3 &b = result.m_OutputVertices[result.m_Indices[i + 1]];
+            const btVector3 &c = result.m_OutputVertices[result.m_Indices[i + 2]];
+            hull.volume += btFabs((a - center).dot((b - center).cross(c - center))) / 6.0f;
+        }
+
+        library.ReleaseResult(result);
+        return hull;
+    }
+
+    inline Hull buildHull(const std::vector<Vertex> &vertices, unsigned maxVertices = HULL_MAX_VERTICES) {
+        std::vector<btVector3> points(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            points[i] = btVector3(vertices[i].pos.x, vertices[i].pos.y, vertices[i].pos.z);
+        }
+        return buildHull(points, maxVertices);
+    }
+
+    inline std::vector<Hull> decompose(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices,
+                                       int maxParts = DECOMPOSITION_MAX_PARTS,
+                                       float concavity = DECOMPOSITION_CONCAVITY,
+                                       unsigned maxVertices = HULL_MAX_VERTICES) {
+        struct Part {
+            std::vector<uint32_t> triangles; // first index of each triangle
+            Hull hull;
+        };
+
+        auto vertexOf = [&](uint32_t index) {
+            const glm::vec3 &p = vertices[index].pos;
+            return btVector3(p.x, p.y, p.z);
+        };
+        auto centroidOf = [&](uint32_t triangle) {
+            return (vertexOf(indices[triangle]) + vertexOf(indices[triangle + 1]) + vertexOf(indices[triangle + 2])) / 3.0f;
+        };
+        auto hullOf = [&](const std::vector<uint32_t> &triangles) {
+            std::vector<btVector3> points;
+            points.reserve(triangles.size() * 3);
+            for (uint32_t triangle : triangles) {
+                for (int k = 0; k < 3; k++) points.push_back(vertexOf(indices[triangle + k]));
+            }
+            return buildHull(points, maxVertices);
+        };
+
+        auto byVolume = [](const Part &a, const Part &b) { return a.hull.volume < b.hull.volume; };
+        std::priority_queue<Part, std::vector<Part>, decltype(byVolume)> open(byVolume);
+        std::vector<Hull> done;
+
+        Part root;
+        for (uint32_t i = 0; i + 2 < indices.size(); i += 3) root.triangles.push_back(i);
+        if (root.triangles.empty()) return done;
+        root.hull = hullOf(root.triangles);
+        open.push(std::move(root));
+
+        while (!open.empty()) {
+            Part part = open.top();
+            open.pop();
+
+            // each split adds one part
+            if ((int)(done.size() + open.size()) + 2 > maxParts || part.triangles.size() < 2 || part.hull.volume <= 0) {
+                done.push_back(std::move(part.hull));
+                continue;
+            }
+
+            btVector3 lo(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+            btVector3 hi = -lo;
+            for (uint32_t triangle : part.triangles) {
+                btVector3 c = centroidOf(triangle);
+                lo.setMin(c);
+                hi.setMax(c);
+            }
+
+            Part bestA, bestB;
+            btScalar bestVolume = BT_LARGE_FLOAT;
+            for (int axis = 0; axis < 3; axis++) {
+                if (hi[axis] - lo[axis] <= SIMD_EPSILON) continue;
+                btScalar plane = (lo[axis] + hi[axis]) * 0.5f;
+
+                Part a, b;
+                for (uint32_t triangle : part.triangles) {
+                    (centroidOf(triangle)[axis] < plane ? a : b).triangles.push_back(triangle);
+                }
+                if (a.triangles.empty() || b.triangles.empty()) continue;
+
+                a.hull = hullOf(a.triangles);
+                b.hull = hullOf(b.triangles);
+                btScalar volume = a.hull.volume + b.hull.volume;
+                if (volume < bestVolume) {
+                    bestVolume = volume;
+                    bestA = std::move(a);
+                    bestB = std::move(b);
+                }
+            }
+
+            // splitting a convex part leaves the total hull volume about the same
+            if (bestVolume >= part.hull.volume * (1.0f - concavity)) {
+                done.push_back(std::move(part.hull));
+                continue;
+            }
+            open.push(std::move(bestA));
+            open.push(std::move(bestB));
+        }
+        return done;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+
+#include "config.h"
+#include "Engine/Node3D.hpp"
+#include "Engine/SkinnedMesh3D.hpp"
+#include "Engine/FrustumCull.hpp"
+
+// Background crowd: many copies of one skinned model playing one clip that
+// is baked at load (SkinnedMesh3D::bakeClip). Members only differ in their
+// placement and time offset, so there is no per-member animation work on the
+// CPU or in the skinning pass; each member is a static draw of its current
+// baked frame. The node transform places the whole crowd.
+class CrowdMesh3D : public Node3D {
+public:
+    struct Member {
+        glm::vec3 offset;    // from the crowd position, world units
+        float yaw;           // radians around the crowd's up axis
+        float timeOffset;    // seconds added to the crowd clock
+        glm::mat4 model{1.0f};
+    };
+
+    SharedSkinnedGeometry* geom = nullptr;
+    const BakedClip* baked = nullptr;
+    std::vector<Member> members;
+
+    float time = 0.0f;
+    float speed = 1.0f;
+    float metallic = 0.0f;
+    float roughness = 0.5f;
+    uint32_t materialFeatures = 0;
+
+    CrowdMesh3D() = default;
+
+    void init(const char* filename, int clip);
+    void destroy();
+
+    // Returns the member index
+    int addMember(glm::vec3 offset, float yaw, float timeOffset);
+    // Same, starting at a random point of the clip
+    int addMember(glm::vec3 offset, float yaw);
+    void setMember(int index, glm::vec3 offset, float yaw);
+    void clearMembers() { members.clear(); }
+    int getMemberCount() const { return (int)members.size(); }
+
+    void setSpeed(float s) { speed = s; }
+    float getSpeed() const { return speed; }
+    void advance(float dt) { time += dt * speed; }
+
+    // Draws every member with the bound static pipeline. Members outside
+    // frustum are skipped; pass null to draw all of them (shadow pass).
+    void draw(VkCommandBuffer commandBuffer, VkPipelineLayout layout, Frustum* frustum);
+
+private:
+    bool membersDirty = true;
+    void updateMatrices();
+};
@@ -20,6 +20,8 @@
 
 #include "Engine/Vertex.hpp"
 #include "Texture.hpp"
+#include "Engine/TextureAtlas.hpp"
+#include "Engine/JobSystem.hpp"
 
 #include "Engine/Engine.hpp"
 
@@ -47,9 +49,8 @@ namespace VK {
     inline VkSurfaceKHR surface;
     inline std::vector<std::string> g_texturePathList;
     inline std::unordered_map<std::string, Texture> textureMap;
-    // Set by Renderer during init so SkinnedMesh3D can allocate bone descriptor sets
-    inline VkDescriptorSetLayout boneDescriptorSetLayout = VK_NULL_HANDLE;
     inline VkDescriptorPool sharedDescriptorPool = VK_NULL_HANDLE;
+    inline VkPipelineCache pipelineCache = VK_NULL_HANDLE;
 };
 
 namespace Command {
@@ -127,10 +128,11 @@ namespace Memory {
         vkBindBufferMemory(VK::device, buffer, bufferMemory, 0);
     }
 
-    inline void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+    inline void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0) {
         VkCommandBuffer commandBuffer = Command::beginSingleTimeCommands();
 
         VkBufferCopy copyRegion{};
+        copyRegion.dstOffset = dstOffset;
         copyRegion.size = size;
         vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
@@ -161,6 +163,17 @@ namespace Utils {
     }
     std::vector<char> readFileZip(const std::string& filename);
     bool fileExistsZip(const std::string& filename);
+
+    // FNV-1a over raw bytes, used for cache keys and file checksums
+    inline uint64_t hashBytes(const void *data, size_t size) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        uint64_t hash = 1469598103934665603ull;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
     
     inline void setViewPort(VkCommandBuffer commandBuffer, glm::vec2 pos, glm::vec2 size, glm::vec2 depth) {
         VkViewport viewport{};
@@ -875,6 +888,37 @@ namespace Assets {
         return translation * rotation * scale;
     };
 
+    // Decodes every texture that isn't loaded yet in one parallel batch and
+    // registers it under its path so the per-primitive lookups below just hit
+    inline void loadTextures(const std::vector<TextureLoadRequest> &requests) {
+        std::vector<TextureLoadRequest> pending;
+        for (const auto &req : requests) {
+            if (std::find(VK::g_texturePathList.begin(), VK::g_texturePathList.end(), req.path) != VK::g_texturePathList.end()) continue;
+            if (std::find_if(pending.begin(), pending.end(), [&](const TextureLoadRequest &p) { return p.path == req.path; }) != pending.end()) continue;
+            if (!req.image && !Utils::fileExistsZip(req.path)) continue;
+            pending.push_back(req);
+        }
+        if (pending.empty()) return;
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<Texture> textures(pending.size());
+        for (size_t i = 0; i < pending.size(); i++) pending[i].texture = &textures[i];
+        Texture::loadBatch(pending);
+
+        for (size_t i = 0; i < pending.size(); i++) {
+            textures[i].textureID = static_cast<int>(VK::g_texturePathList.size());
+            textures[i].createTextureImageView();
+            VK::textureMap[pending[i].path] = textures[i];
+            VK::g_texturePathList.push_back(pending[i].path);
+        }
+
+        auto ms = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0;
+        char msg[128];
+        snprintf(msg, sizeof(msg), "Loaded %zu textures in %.2fms on %u threads", pending.size(), ms, Jobs::threadCount());
+        Logger::info("Texture", msg);
+    }
+
     inline void loadModel(const char* filename, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices, glm::vec3 &AA, glm::vec3 &BB, glm::vec3 &vertexCenter) {
         // Create a tinygltf model, options and error/warning strings
         tinygltf::Model model;
@@ -921,6 +965,48 @@ namespace Assets {
         int rootNodeIdx = model.scenes[model.defaultScene].nodes[0];
         glm::mat4 rootMat = getLocalMatrix(model.nodes[rootNodeIdx]);
 
+        // Small base colour textures get packed into a shared atlas up front
+        std::unordered_map<int, AtlasRegion> atlas = TextureAtlas::packModel(model, filename);
+
+        // Queue up every other texture so they decode in parallel, naming them
+        // the same way the per-primitive lookups below do
+        std::vector<TextureLoadRequest> textureRequests;
+        auto queueTexture = [&](int materialIndex, int textureIndex, const char *suffix, VkFormat embeddedFormat) {
+            if (textureIndex < 0) return;
+            int sourceIndex = model.textures[textureIndex].source;
+            if (sourceIndex < 0 || sourceIndex >= model.images.size()) return;
+
+            const tinygltf::Material &material = model.materials[materialIndex];
+            const tinygltf::Image &image = model.images[sourceIndex];
+            TextureLoadRequest req;
+            if (!image.uri.empty()) {
+                req.path = std::string("assets/textures/") + image.uri;
+            } else {
+                if (!image.name.empty()) {
+                    req.path = image.name;
+                } else if (!material.name.empty()) {
+                    req.path = material.name + suffix;
+                } else {
+                    req.path = "material_" + std::to_string(materialIndex) + suffix;
+                }
+                req.image = &image;
+                req.format = embeddedFormat;
+            }
+            textureRequests.push_back(req);
+        };
+        for (const auto &mesh : model.meshes) {
+            for (const auto &primitive : mesh.primitives) {
+                if (primitive.material < 0 || primitive.material >= model.materials.size()) continue;
+                const tinygltf::Material &material = model.materials[primitive.material];
+                int colorIndex = material.pbrMetallicRoughness.baseColorTexture.index;
+                if (colorIndex >= 0 && atlas.find(model.textures[colorIndex].source) == atlas.end()) {
+                    queueTexture(primitive.material, colorIndex, "_texture", VK_FORMAT_R8G8B8A8_SRGB);
+                }
+                queueTexture(primitive.material, material.normalTexture.index, "_normal_texture", VK_FORMAT_R8G8B8A8_SRGB);
+                queueTexture(primitive.material, material.pbrMetallicRoughness.metallicRoughnessTexture.index, "_mr_texture", VK_FORMAT_R8G8B8A8_UNORM);
+            }
+        }
+        loadTextures(textureRequests);
         
         // Process all meshes in the model
         for (size_t i = 0; i < model.meshes.size(); i++) {
@@ -935,6 +1021,7 @@ namespace Assets {
                 int textureID = 0; // Default texture ID
                 int normalID = -1; // default normal Map ID
                 int metallicRoughnessID = -1; // default metallic/roughness Map ID
+                const AtlasRegion *region = nullptr;
 
 
                 
@@ -942,8 +1029,15 @@ namespace Assets {
                 if (materialIndex >= 0 && materialIndex < model.materials.size()) {
                     const tinygltf::Material &material = model.materials[materialIndex];
                     
-                    // Check for base color texture
-                    if (material.pbrMetallicRoughness.baseColorTexture.index >= 0) {
+                    int colorIndex = material.pbrMetallicRoughness.baseColorTexture.index;
+                    auto atlasIt = (colorIndex >= 0) ? atlas.find(model.textures[colorIndex].source) : atlas.end();
+
+                    if (atlasIt != atlas.end()) {
+                        // Packed into the atlas, UVs get remapped below
+                        region = &atlasIt->second;
+                        textureID = region->textureID;
+                    } else if (colorIndex >= 0) {
+                        // Check for base color texture
                         int textureIndex = material.pbrMetallicRoughness.baseColorTexture.index;
                         // wip load normal map
                         int sourceIndex = model.textures[textureIndex].source;
@@ -1248,6 +1342,9 @@ namespace Assets {
                         } else {
                             vertex.texCoord = {0.0f, 0.0f}; // Default
                         }
+                        if (region) {
+                            vertex.texCoord = region->remap(vertex.texCoord);
+                        }
 
                         // store the normal
                         if (normalData) {
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small shared worker pool used for asset decoding and other embarrassingly
+// parallel work. Workers are started lazily on first use and live for the
+// whole process.
+namespace Jobs {
+    class ThreadPool {
+    public:
+        explicit ThreadPool(unsigned int threadCount) {
+            for (unsigned int i = 0; i < threadCount; i++) {
+                workers.emplace_back([this]() { workerLoop(); });
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            cv.notify_all();
+            for (auto& worker : workers) worker.join();
+        }
+
+        void push(std::function<void()> job) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.push_back(std::move(job));
+            }
+            cv.notify_one();
+        }
+
+        size_t size() const { return workers.size(); }
+
+    private:
+        void workerLoop() {
+            for (;;) {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [this]() { return stopping || !queue.empty(); });
+                    if (stopping && queue.empty()) return;
+                    job = std::move(queue.front());
+                    queue.pop_front();
+                }
+                job();
+            }
+        }
+
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> queue;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool stopping = false;
+    };
+
+    inline ThreadPool& pool() {
+        // leave one core for the calling thread, which always helps out
+        static ThreadPool instance(std::max(1u, std::thread::hardware_concurrency()) - 1);
+        return instance;
+    }
+
+    inline unsigned int threadCount() {
+        return (unsigned int)pool().size() + 1;
+    }
+
+    // Runs fn(i) for every i in [0, count) across the pool and the calling
+    // thread, returning once all of them finished. Safe to call from inside a
+    // job: the caller keeps pulling indices itself, so it never waits on a
+    // helper that hasn't started. If fn throws, the remaining indices are
+    // skipped and the first exception is rethrown on the caller once no
+    // helper is inside fn any more.
+    template<typename F>
+    inline void parallelFor(size_t count, F&& fn) {
+        if (count == 0) return;
+        if (count == 1 || pool().size() == 0) {
+            for (size_t i = 0; i < count; i++) fn(i);
+            return;
+        }
+
+        struct State {
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> done{0};
+            size_t count;
+            std::function<void(size_t)> fn;
+            std::atomic<bool> failed{false};
+            std::exception_ptr error; // first one, guarded by mutex
+            std::mutex mutex;
+            std::condition_variable cv;
+        };
+        auto state = std::make_shared<State>();
+        state->count = count;
+        state->fn = [&fn](size_t i) { fn(i); };
+
+        auto drain = [](State& s) {
+            for (size_t i = s.next++; i < s.count; i = s.next++) {
+                // every claimed index still counts as done, so the caller
+                // can't return while a helper is running fn
+                if (!s.failed.load(std::memory_order_relaxed)) {
+                    try {
+                        s.fn(i);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(s.mutex);
+                        if (!s.error) s.error = std::current_exception();
+                        s.failed = true;
+                    }
+                }
+                if (++s.done == s.count) {
+                    std::lock_guard<std::mutex> lock(s.mutex);
+                    s.cv.notify_all();
+                }
+            }
+        };
+
+        size_t helpers = std::min(count - 1, pool().size());
+        for (size_t h = 0; h < helpers; h++) {
+            pool().push([state, drain]() { drain(*state); });
+        }
+        drain(*state);
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cv.wait(lock, [&]() { return state->done == state->count; });
+        if (state->error) std::rethrow_exception(state->error);
+    }
+};
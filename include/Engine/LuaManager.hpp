@@ -4,6 +4,7 @@
 #include <imgui.h>
 #include "Engine/Mesh3D.hpp"
 #include "Engine/SkinnedMesh3D.hpp"
+#include "Engine/CrowdMesh3D.hpp"
 #include "Engine/Camera.hpp"
 #include "Engine/Window.hpp"
 
@@ -12,12 +12,14 @@
 #include "btBulletDynamicsCommon.h"
 #include "LinearMath/btVector3.h"
 #include "LinearMath/btAlignedObjectArray.h"
+#include "Engine/PhysicsState.hpp"
 
 // to differentiate collider types
 enum ColliderType {
     BOX,
     CONVEXHULL,
-    TRIMESH
+    TRIMESH,
+    DECOMPOSED // compound of convex hulls, for dynamic concave props
 };
 
 // Geometry shared across all instances of the same model file.
@@ -31,6 +33,7 @@ struct SharedMeshGeometry {
     VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
     VkBuffer       indexBuffer        = VK_NULL_HANDLE;
     VkDeviceMemory indexBufferMemory  = VK_NULL_HANDLE;
+    uint32_t materialFeatures = 0;
     int refCount = 0;
 };
 
@@ -41,8 +44,9 @@ public:
     SharedMeshGeometry* sharedGeom = nullptr;  // non-null when using cached geometry
 
     bool hasPhysics = false;
+    ActivationPolicy activationPolicy = ACTIVATION_AUTO;
 
-    btRigidBody* rigidBody;
+    btRigidBody* rigidBody = nullptr;
 
     glm::vec3 AA;
     glm::vec3 BB;
@@ -65,6 +69,9 @@ public:
     float metallic = 0.0f;
     float roughness = 0.5f;
 
+    // MaterialFeature bits, picks the main-pass pipeline variant
+    uint32_t materialFeatures = 0;
+
     Mesh3D() {
 
     }
@@ -81,10 +88,19 @@ public:
     void draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, int count);
     void updatePushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout);
     void createRigidBody(float mass, ColliderType colliderType);
+    // Returns the body to the pool; it must not be in a world anymore
+    void destroyRigidBody();
+    // Setters are queued to the physics thread, getters read the last step
     void setLinearVelocity(glm::vec3 velocity);
     glm::vec3 getLinearVelocity() const;
     glm::vec3 getPhysicsPosition() const;
-    void setFriction(float f)               { if (hasPhysics) rigidBody->setFriction(f); }
-    void setRestitution(float r)            { if (hasPhysics) rigidBody->setRestitution(r); }
-    void setDamping(float linear, float angular) { if (hasPhysics) rigidBody->setDamping(linear, angular); }
+    void setFriction(float f);
+    void setRestitution(float r);
+    void setDamping(float linear, float angular);
+    void setActivationPolicy(ActivationPolicy policy);
+    ActivationPolicy getActivationPolicy() const { return activationPolicy; }
+    void wake();
+    bool isSleeping() const;
+    // Identifies the body in physics query results, -1 without one
+    int getBodyId() const { return hasPhysics ? rigidBody->getUserIndex() : -1; }
 };
\ No newline at end of file
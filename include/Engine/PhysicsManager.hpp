@@ -5,8 +5,15 @@
 #include "LinearMath/btVector3.h"
 #include "LinearMath/btAlignedObjectArray.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 // engine includes
 #include "Mesh3D.hpp"
@@ -14,6 +21,12 @@
 #include "Camera.hpp"
 #include "DebugMesh.hpp"
 #include "Engine.hpp"
+#include "BodyPool.hpp"
+#include "CharacterController.hpp"
+#include "PhysicsQuery.hpp"
+#include "PhysicsState.hpp"
+#include "PhysicsWorld.hpp"
+#include "config.h"
 
 struct BulletContactResultCallback : public btCollisionWorld::ContactResultCallback {
 public:
@@ -39,15 +52,85 @@ public:
 };
 
 namespace Physics {
+    // Owns the Bullet world and steps it on a dedicated thread. Each frame the
+    // main thread calls process(): if the previous step has finished it pins
+    // that step's snapshot, syncs meshes from it and starts the next step,
+    // which then runs alongside command buffer recording. If the step is
+    // still running the frame's time is carried over to the next kick.
     class PhysicsManager {
         std::vector<Mesh3D*> meshes;
         std::vector<SkinnedMesh3D*> skinnedMeshes; // runtime-registered character bodies
         Camera *camera;
 
-        std::unique_ptr<btDefaultCollisionConfiguration> collisionConfiguration;
-        std::unique_ptr<btCollisionDispatcher> dispatcher;
-        std::unique_ptr<btBroadphaseInterface> overlappingPairCache;
-        std::unique_ptr<btSequentialImpulseConstraintSolver> solver;
+        World world;
+
+        SharedState shared;
+
+        // Snapshot slots (body user index), handed out on the main thread
+        std::vector<int> freeSlots;
+        int slotCount = 0;
+
+        // Main thread only: the mesh each slot syncs to, null for the camera,
+        // skinned meshes and free slots
+        std::vector<Mesh3D*> slotMeshes;
+
+        // Fixed-step state, physics thread only. previousTransforms holds the
+        // transform of each active body before the last step, by slot;
+        // entries from older captures are stale.
+        struct PreviousTransform {
+            btTransform transform;
+            uint32_t capture = 0;
+        };
+        std::atomic<float> fixedTimeStep{1.0f / PHYSICS_HZ};
+        std::atomic<int> maxSubSteps{PHYSICS_MAX_SUBSTEPS};
+        std::atomic<float> interpolationAlpha{1.0f};
+        double accumulator = 0.0;
+        btAlignedObjectArray<PreviousTransform> previousTransforms;
+        uint32_t captureId = 0;
+
+        // Kinematic characters, physics thread only (the camera's is added
+        // before the thread starts), moved before each fixed step
+        std::vector<std::shared_ptr<CharacterController>> controllers;
+        btAlignedObjectArray<btVector3> characterMoves;
+
+        // Physics thread only, written into the next snapshot regardless of
+        // activity: new bodies (statics get their only write here) and slots
+        // of removed ones
+        std::vector<btCollisionObject*> addedObjects;
+        std::vector<int> clearedSlots;
+
+        // Removed bodies, main thread. Removal runs on the physics thread, so
+        // a body only becomes reusable (parked) or goes back to the BodyPool
+        // once the step its command was queued for has finished: queued ->
+        // in flight at the next kick -> settled when that step is done.
+        // Parked bodies stay in the world, disabled and filtered out of the
+        // broadphase, so reusing one skips the proxy removal and reinsertion.
+        struct Removal {
+            btRigidBody *body;
+            bool park;
+        };
+        std::vector<Removal> removalsQueued;
+        std::vector<Removal> removalsInFlight;
+        // A parked body only stands in for one of the same shape and kind
+        // (dynamic, static, kinematic): the world decides once, in
+        // addRigidBody, whether a body is in the list it integrates.
+        using ParkKey = std::pair<const btCollisionShape*, int>;
+        std::map<ParkKey, std::vector<btRigidBody*>> parked;
+        std::map<ParkKey, int> parkedCount; // including queued ones
+
+        // Submitted query batches, guarded by shared.commandMutex; run after
+        // the next step
+        std::vector<std::shared_ptr<QueryBatch>> pendingQueries;
+
+        // Main thread <-> physics thread handoff
+        std::thread worker;
+        std::mutex wakeMutex;
+        std::condition_variable wake;
+        bool kicked = false;
+        bool quit = false;
+        float stepDelta = 0.0f;
+        std::atomic<bool> busy{false};
+        float pendingDelta = 0.0f; // main thread only
         
     public:
         // need public access to draw in render loop
@@ -55,6 +138,15 @@ namespace Physics {
         std::shared_ptr<btDiscreteDynamicsWorld> dynamicsWorld;
 
         ~PhysicsManager() {
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                quit = true;
+            }
+            wake.notify_one();
+            if (worker.joinable()) worker.join();
+
+            for (std::shared_ptr<QueryBatch> &batch : pendingQueries) batch->cancel();
+
             // Remove all rigid bodies from the world before it is destroyed.
             // Bullet requires this so its broadphase/dispatcher stay consistent.
             if (dynamicsWorld) {
@@ -63,21 +155,19 @@ namespace Physics {
                         dynamicsWorld->getCollisionObjectArray()[i]);
                 }
             }
+
+            // bodies still owned by meshes are returned when those are destroyed
+            for (const Removal &removal : removalsQueued) BodyPool::destroy(removal.body);
+            for (const Removal &removal : removalsInFlight) BodyPool::destroy(removal.body);
+            for (auto &[key, bodies] : parked) {
+                for (btRigidBody *body : bodies) BodyPool::destroy(body);
+            }
         }
 
         void init() {
-            collisionConfiguration = std::make_unique<btDefaultCollisionConfiguration>();
-            dispatcher = std::make_unique<btCollisionDispatcher>(collisionConfiguration.get());
-            overlappingPairCache = std::make_unique<btDbvtBroadphase>();
-            solver = std::make_unique<btSequentialImpulseConstraintSolver>();
-
-            // Create dynamics world
-            dynamicsWorld = std::make_shared<btDiscreteDynamicsWorld> (
-                dispatcher.get(), 
-                overlappingPairCache.get(), 
-                solver.get(), 
-                collisionConfiguration.get()
-            );
+            // Create dynamics world (multithreaded with VORPAL_PHYSICS_MT)
+            world.create();
+            dynamicsWorld = world.dynamicsWorld;
 
             // load debug renderer
 #ifdef DRAW_DEBUG
@@ -85,20 +175,22 @@ namespace Physics {
             dynamicsWorld->setDebugDrawer(debugDrawer);
 #endif
 
-            // Set gravity
-            dynamicsWorld->setGravity(btVector3(0, -9.81f, 0));
-
             for (Mesh3D *mesh : meshes) {
                 if (!mesh->hasPhysics) { // skip non-physics meshes
                     continue;
                 }
-                mesh->rigidBody->setActivationState(DISABLE_DEACTIVATION);
                 mesh->rigidBody->setFriction(2.0f);
+                assignSlot(mesh->rigidBody, mesh);
                 dynamicsWorld->addRigidBody(mesh->rigidBody);
+                addedObjects.push_back(mesh->rigidBody);
             }
             
-            camera->rigidBody->setActivationState(DISABLE_DEACTIVATION);
+            assignSlot(camera->rigidBody);
             dynamicsWorld->addRigidBody(camera->rigidBody);
+            addedObjects.push_back(camera->rigidBody);
+            controllers.push_back(camera->controller);
+
+            worker = std::thread([this] { run(); });
         }
 
         PhysicsManager(std::vector<Mesh3D *> &meshes, Camera *camera) {
@@ -107,23 +199,326 @@ namespace Physics {
             init();
         }
 
+        // May swap sm->rigidBody for a parked body set up the same way
         void addSkinnedRigidBody(SkinnedMesh3D* sm) {
-            dynamicsWorld->addRigidBody(sm->rigidBody);
+            sm->rigidBody = adopt(sm->rigidBody);
             skinnedMeshes.push_back(sm);
+
+            if (sm->character) {
+                std::shared_ptr<CharacterController> character = sm->character;
+                character->body = sm->rigidBody;
+                enqueue(sm->rigidBody, [this, character] { controllers.push_back(character); });
+            }
         }
 
+        // The manager takes over the mesh's body
         void removeSkinnedRigidBody(SkinnedMesh3D* sm) {
-            dynamicsWorld->removeRigidBody(sm->rigidBody);
             skinnedMeshes.erase(std::remove(skinnedMeshes.begin(), skinnedMeshes.end(), sm), skinnedMeshes.end());
+            btRigidBody *body = sm->rigidBody;
+            if (!removeBody(body)) return;
+
+            if (sm->character) {
+                std::shared_ptr<CharacterController> character = sm->character;
+                enqueue(body, [this, character] {
+                    controllers.erase(std::remove(controllers.begin(), controllers.end(), character), controllers.end());
+                });
+                sm->character.reset();
+            }
+            sm->rigidBody = nullptr;
+            sm->hasPhysics = false;
+        }
+
+        // For physics meshes removed from the scene after init
+        void removeRigidBody(Mesh3D* mesh) {
+            meshes.erase(std::remove(meshes.begin(), meshes.end(), mesh), meshes.end());
+            if (removeBody(mesh->rigidBody)) {
+                mesh->rigidBody = nullptr;
+                mesh->hasPhysics = false;
+            }
+        }
+
+        void setFixedRate(float hz) { fixedTimeStep = 1.0f / std::max(hz, 1.0f); }
+        float getFixedRate() const { return 1.0f / fixedTimeStep; }
+        void setMaxSubSteps(int steps) { maxSubSteps = std::max(steps, 1); }
+        int getMaxSubSteps() const { return maxSubSteps; }
+        // How far the render time is between the last two steps, 0..1
+        float getInterpolationAlpha() const { return interpolationAlpha; }
+
+        // Main thread. The batch belongs to the physics thread until it is
+        // ready, at most one step later; poll it with isReady().
+        void submitQueries(std::shared_ptr<QueryBatch> batch) {
+            batch->markPending();
+            std::lock_guard<std::mutex> lock(shared.commandMutex);
+            pendingQueries.push_back(std::move(batch));
+        }
+
+        // Main thread, once per frame. Never waits on the physics thread.
+        void process(float deltaTime) {
+            pendingDelta += deltaTime;
+            if (busy.load(std::memory_order_acquire)) return;
+
+            // physics thread is idle: its last snapshot is complete and the
+            // world is safe to read until the next kick
+            shared.readIndex = shared.published.load(std::memory_order_acquire);
+            settleRemovals();
+
+            // draw debug
+#ifdef DRAW_DEBUG
+            dynamicsWorld->debugDrawWorld();
+#endif
+
+            syncFromSnapshot();
+
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                stepDelta = pendingDelta;
+                kicked = true;
+                busy.store(true, std::memory_order_relaxed);
+            }
+            pendingDelta = 0.0f;
+            removalsInFlight.swap(removalsQueued);
+            wake.notify_one();
         }
 
-        void syncMesh(Mesh3D *mesh, btRigidBody *body) {
-            btVector3 pos = body->getInterpolationWorldTransform().getOrigin();
-            btQuaternion rot = body->getInterpolationWorldTransform().getRotation();
-            mesh->setOrientation( glm::quat(rot.getW(), rot.getX(), rot.getY(), rot.getZ()) );
-            mesh->setPosition(physicsToWorld(pos));
+    private:
+        static ParkKey parkKey(const btRigidBody *body) {
+            // kinematic bodies have mass 0, so they count as static too
+            int kind = body->isKinematicObject() ? 2 : body->isStaticObject() ? 1 : 0;
+            return {body->getCollisionShape(), kind};
+        }
+
+        void assignSlot(btCollisionObject *body, Mesh3D *mesh = nullptr) {
+            int slot;
+            if (!freeSlots.empty()) {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            } else {
+                slot = slotCount++;
+            }
+            body->setUserIndex(slot);
+            body->setUserPointer(&shared);
+            if (slot >= (int)slotMeshes.size()) slotMeshes.resize(slot + 1, nullptr);
+            slotMeshes[slot] = mesh;
+        }
+
+        // Registers a body built for this world, or hands back a parked one
+        // of the same shape and kind set up like it (fresh goes back to the pool).
+        // A parked body's user index is only read by the physics thread
+        // once it is enabled again, so it can be reassigned here.
+        btRigidBody *adopt(btRigidBody *fresh) {
+            auto it = parked.find(parkKey(fresh));
+            if (it == parked.end() || it->second.empty()) {
+                assignSlot(fresh);
+                enqueue(fresh, [this, fresh] {
+                    dynamicsWorld->addRigidBody(fresh);
+                    addedObjects.push_back(fresh);
+                });
+                return fresh;
+            }
+
+            btRigidBody *body = it->second.back();
+            it->second.pop_back();
+            parkedCount[it->first]--;
+
+            BodySetup setup = BodySetup::of(*fresh);
+            BodyPool::destroy(fresh);
+            assignSlot(body);
+            enqueue(body, [this, body, setup] {
+                unpark(body, setup);
+                addedObjects.push_back(body);
+            });
+            return body;
+        }
+
+        // False if body isn't registered here; otherwise the manager owns it
+        bool removeBody(btRigidBody *body) {
+            if (sharedStateOf(body) != &shared) return false;
+
+            int slot = body->getUserIndex();
+            slotMeshes[slot] = nullptr;
+            freeSlots.push_back(slot);
+
+            int &count = parkedCount[parkKey(body)];
+            bool park = count < PHYSICS_PARKED_PER_SHAPE;
+            if (park) count++;
+            removalsQueued.push_back({body, park});
+
+            enqueue(body, [this, body, slot, park] {
+                if (park)
+                    this->park(body);
+                else
+                    dynamicsWorld->removeRigidBody(body);
+                addedObjects.erase(std::remove(addedObjects.begin(), addedObjects.end(), body), addedObjects.end());
+                clearedSlots.push_back(slot);
+            });
+            return true;
+        }
+
+        // Main thread, physics thread idle: removals that were in flight ran
+        void settleRemovals() {
+            for (const Removal &removal : removalsInFlight) {
+                if (removal.park)
+                    parked[parkKey(removal.body)].push_back(removal.body);
+                else
+                    BodyPool::destroy(removal.body);
+            }
+            removalsInFlight.clear();
+        }
+
+        // Physics thread. The proxy stays where it is but pairs with nothing,
+        // and the body is skipped by stepping, snapshots and queries.
+        void park(btRigidBody *body) {
+            body->forceActivationState(DISABLE_SIMULATION);
+            body->setLinearVelocity(btVector3(0, 0, 0));
+            body->setAngularVelocity(btVector3(0, 0, 0));
+
+            btBroadphaseProxy *proxy = body->getBroadphaseHandle();
+            proxy->m_collisionFilterGroup = 0;
+            proxy->m_collisionFilterMask = 0;
+            dynamicsWorld->getPairCache()->removeOverlappingPairsContainingProxy(proxy, dynamicsWorld->getDispatcher());
+        }
+
+        // Physics thread, as addRigidBody would have set it up
+        void unpark(btRigidBody *body, const BodySetup &setup) {
+            setup.applyTo(body);
+
+            bool isDynamic = !(body->isStaticObject() || body->isKinematicObject());
+            btBroadphaseProxy *proxy = body->getBroadphaseHandle();
+            proxy->m_collisionFilterGroup = isDynamic ? btBroadphaseProxy::DefaultFilter : btBroadphaseProxy::StaticFilter;
+            proxy->m_collisionFilterMask = isDynamic ? btBroadphaseProxy::AllFilter
+                                                     : btBroadphaseProxy::AllFilter ^ btBroadphaseProxy::StaticFilter;
+            // moving the proxy to the new transform finds its pairs
+            dynamicsWorld->updateSingleAabb(body);
+        }
+
+        // Transform to render body with: between its last two steps by
+        // interpolationAlpha if it was captured before the last one
+        btTransform interpolatedTransform(const btCollisionObject *body) const {
+            const btTransform &current = body->getWorldTransform();
+            int slot = body->getUserIndex();
+            if (slot < 0 || slot >= previousTransforms.size()) return current;
+            const PreviousTransform &previous = previousTransforms[slot];
+            if (previous.capture != captureId) return current;
+
+            float alpha = interpolationAlpha.load(std::memory_order_relaxed);
+            btTransform result;
+            result.setOrigin(previous.transform.getOrigin().lerp(current.getOrigin(), alpha));
+            result.setRotation(previous.transform.getRotation().slerp(current.getRotation(), alpha));
+            return result;
+        }
+
+        // Writes back only what the last step moved
+        void syncFromSnapshot() {
+            const Snapshot &snapshot = shared.current();
+            int cameraSlot = camera->rigidBody->getUserIndex();
+
+            for (int slot : snapshot.moved) {
+                const BodyState &state = snapshot.bodies[slot];
+                if (!state.valid) continue; // removed
+
+                if (slot == cameraSlot) {
+                    camera->setPosition(state.position + glm::vec3(0.0, 0.25, 0.0));
+                    continue;
+                }
+                // Skinned mesh visual positions are Lua-controlled via getPhysicsPosition().
+                Mesh3D *mesh = slot < (int)slotMeshes.size() ? slotMeshes[slot] : nullptr;
+                if (!mesh) continue;
+                mesh->setOrientation(state.orientation);
+                mesh->setPosition(state.position);
+            }
+            camera->grounded = snapshot.cameraGrounded;
+        }
+
+        void run() {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            while (true) {
+                wake.wait(lock, [this] { return kicked || quit; });
+                if (quit) break;
+                kicked = false;
+                float deltaTime = stepDelta;
+                lock.unlock();
+
+                runCommands();
+                step(deltaTime);
+                runQueries();
+                writeSnapshot();
+                busy.store(false, std::memory_order_release);
+
+                lock.lock();
+            }
+        }
+
+        void runCommands() {
+            std::vector<Command> commands;
+            {
+                std::lock_guard<std::mutex> lock(shared.commandMutex);
+                commands.swap(shared.pendingCommands);
+            }
+            for (Command &command : commands) command();
+        }
+
+        void runQueries() {
+            std::vector<std::shared_ptr<QueryBatch>> batches;
+            {
+                std::lock_guard<std::mutex> lock(shared.commandMutex);
+                batches.swap(pendingQueries);
+            }
+            for (std::shared_ptr<QueryBatch> &batch : batches) batch->execute(dynamicsWorld.get(), &shared);
+        }
+
+        // Advances the world by whole fixed steps covering deltaTime, up to
+        // maxSubSteps per call; time beyond that is dropped rather than owed,
+        // so a slow frame can't snowball into ever more steps.
+        void step(float deltaTime) {
+            float fixed = fixedTimeStep.load(std::memory_order_relaxed);
+            int cap = maxSubSteps.load(std::memory_order_relaxed);
+
+            accumulator += deltaTime;
+            int steps = (int)(accumulator / fixed);
+            if (steps > cap) {
+                steps = cap;
+                accumulator = steps * (double)fixed;
+            }
+
+            btAlignedObjectArray<btRigidBody*> &bodies = dynamicsWorld->getNonStaticRigidBodies();
+            for (int i = 0; i < steps; i++) {
+                if (i == steps - 1) {
+                    // only the last step's start is needed for interpolation,
+                    // and only bodies that can move during it
+                    captureId++;
+                    for (int j = 0; j < bodies.size(); j++) {
+                        btRigidBody *body = bodies[j];
+                        if (!body->isActive()) continue;
+                        int slot = body->getUserIndex();
+                        if (slot < 0) continue;
+                        if (slot >= previousTransforms.size()) previousTransforms.resize(slot + 1);
+                        previousTransforms[slot].transform = body->getWorldTransform();
+                        previousTransforms[slot].capture = captureId;
+                    }
+                    // characters are mass 0, so Bullet files them as static
+                    // and they are not in the list above
+                    for (const std::shared_ptr<CharacterController> &controller : controllers) {
+                        int slot = controller->body->getUserIndex();
+                        if (slot < 0) continue;
+                        if (slot >= previousTransforms.size()) previousTransforms.resize(slot + 1);
+                        previousTransforms[slot].transform = controller->body->getWorldTransform();
+                        previousTransforms[slot].capture = captureId;
+                    }
+                }
+                moveCharacters(fixed);
+                // maxSubSteps 0: exactly one step of exactly fixedTimeStep
+                dynamicsWorld->stepSimulation(fixed, 0);
+            }
+            accumulator -= steps * (double)fixed;
+            interpolationAlpha.store((float)(accumulator / fixed), std::memory_order_relaxed);
+
+            // bring back anything that fell out of the level, in one pass
+            // over the bodies that can move
+            for (int i = 0; i < bodies.size(); i++) {
+                btRigidBody *body = bodies[i];
+                if (body == camera->rigidBody || !body->isActive() || body->isKinematicObject()) continue;
+                if (body->getWorldTransform().getOrigin().getY() >= PHYSICS_KILL_Y) continue;
 
-            if (pos.getY() < -20.0) {
                 btTransform tran;
                 tran.setIdentity();
                 tran.setOrigin(btVector3(0.0, 5.0, 0.0));
@@ -134,24 +529,91 @@ namespace Physics {
             }
         }
 
-        void process(float deltaTime) {
-            dynamicsWorld->stepSimulation(deltaTime, 1.0);
+        // Sweeps every character against the world as it stands before the
+        // step, in parallel, then hands the results to their bodies; the step
+        // carries them there and pushes dynamic bodies out of the way
+        void moveCharacters(float dt) {
+            if (controllers.empty()) return;
+            characterMoves.resize((int)controllers.size());
+            btCollisionWorld *collisionWorld = dynamicsWorld.get();
+            Jobs::parallelFor(controllers.size(), [&](size_t i) {
+                characterMoves[(int)i] = controllers[i]->computeMove(collisionWorld, dt);
+            });
+            for (size_t i = 0; i < controllers.size(); i++) controllers[i]->applyMove(characterMoves[(int)i]);
+        }
 
-            // draw debug
-#ifdef DRAW_DEBUG
-            dynamicsWorld->debugDrawWorld();
-#endif
+        void writeState(Snapshot &snapshot, btCollisionObject *object) {
+            int slot = object->getUserIndex();
+            if (slot < 0) return;
+            if (slot >= (int)snapshot.bodies.size()) snapshot.bodies.resize(slot + 1);
+
+            BodyState &state = snapshot.bodies[slot];
+            btTransform transform = interpolatedTransform(object);
+            btQuaternion rot = transform.getRotation();
+            state.position = physicsToWorld(transform.getOrigin());
+            state.orientation = glm::quat(rot.getW(), rot.getX(), rot.getY(), rot.getZ());
 
-            //float velY = camera->rigidBody->getLinearVelocity().getY();
-            //camera->rigidBody->setLinearVelocity(worldToPhysics(camera->getVelocity()) + btVector3(0.0, velY, 0.0));
-            //camera->resetVelocity();
+            btVector3 AA, BB;
+            object->getCollisionShape()->getAabb(object->getWorldTransform(), AA, BB);
+            state.aabbMin = glm::vec3(AA.getX(), AA.getY(), AA.getZ());
+            state.aabbMax = glm::vec3(BB.getX(), BB.getY(), BB.getZ());
+
+            btRigidBody *body = btRigidBody::upcast(object);
+            state.linearVelocity = body ? physicsToWorld(body->getLinearVelocity()) : glm::vec3(0.0f);
+            state.sleeping = !object->isActive();
+            state.valid = true;
+            snapshot.moved.push_back(slot);
+        }
 
-            camera->setPosition(physicsToWorld(camera->rigidBody->getInterpolationWorldTransform().getOrigin()) + glm::vec3(0.0, 0.25, 0.0));
-            for (Mesh3D* mesh : meshes) {
-                if (!mesh->hasPhysics) continue;
-                syncMesh(mesh, mesh->rigidBody);
+        // Fills the snapshot the main thread isn't reading and publishes it.
+        // That one is two publishes old, so it first takes over what the last
+        // publish changed; after that only bodies that moved (active ones, and
+        // ones that just fell asleep), were added or removed are written.
+        // Static bodies are written once, when added.
+        void writeSnapshot() {
+            int last = shared.published.load(std::memory_order_relaxed);
+            int target = 1 - last;
+            const Snapshot &previous = shared.snapshots[last];
+            Snapshot &snapshot = shared.snapshots[target];
+
+            if (snapshot.bodies.size() < previous.bodies.size()) snapshot.bodies.resize(previous.bodies.size());
+            for (int slot : previous.moved) snapshot.bodies[slot] = previous.bodies[slot];
+            snapshot.moved.clear();
+
+            for (int slot : clearedSlots) {
+                if (slot >= (int)snapshot.bodies.size()) continue;
+                snapshot.bodies[slot].valid = false;
+                snapshot.moved.push_back(slot);
             }
-            // Skinned mesh visual positions are Lua-controlled via getPhysicsPosition().
+            clearedSlots.clear();
+
+            for (btCollisionObject *object : addedObjects) writeState(snapshot, object);
+            addedObjects.clear();
+
+            btAlignedObjectArray<btRigidBody*> &bodies = dynamicsWorld->getNonStaticRigidBodies();
+            for (int i = 0; i < bodies.size(); i++) {
+                btRigidBody *body = bodies[i];
+                if (body->getActivationState() == DISABLE_SIMULATION) continue; // parked
+                int slot = body->getUserIndex();
+                if (slot < 0) continue;
+                if (!body->isActive()) {
+                    // asleep: write once more to publish that, then never again
+                    if (slot < (int)snapshot.bodies.size() && snapshot.bodies[slot].sleeping) continue;
+                }
+                writeState(snapshot, body);
+            }
+
+            // characters are kinematic with mass 0, which Bullet counts as
+            // static, so the loop above never sees them; they move every step
+            for (const std::shared_ptr<CharacterController> &controller : controllers) {
+                int slot = controller->body->getUserIndex();
+                if (slot < 0) continue;
+                writeState(snapshot, controller->body);
+                snapshot.bodies[slot].grounded = controller->grounded;
+            }
+            snapshot.cameraGrounded = camera->controller->grounded;
+
+            shared.published.store(target, std::memory_order_release);
         }
     };
 }
\ No newline at end of file
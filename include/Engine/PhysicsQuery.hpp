@@ -0,0 +1,440 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "btBulletDynamicsCommon.h"
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
+#include "BulletCollision/NarrowPhaseCollision/btGjkEpaPenetrationDepthSolver.h"
+#include "BulletCollision/NarrowPhaseCollision/btGjkPairDetector.h"
+#include "BulletCollision/NarrowPhaseCollision/btPointCollector.h"
+#include "BulletCollision/NarrowPhaseCollision/btVoronoiSimplexSolver.h"
+
+#include "Engine/JobSystem.hpp"
+#include "Engine/PhysicsState.hpp"
+
+// Batched scene queries for gameplay and AI: rays, sphere/capsule sweeps and
+// sphere/capsule overlaps, physics units.
+//
+// A batch is filled on the main thread and handed to
+// PhysicsManager::submitQueries; the physics thread runs it right after its
+// next step and marks it ready, so results are one step old at most. Every
+// query walks the broadphase trees itself (btDbvt's own traversal keeps its
+// stack local, unlike btCollisionWorld::rayTest) and runs the narrowphase
+// through Bullet's static single-object tests, which lets the whole batch
+// run across the job pool with nothing shared but the read-only world.
+//
+// Bodies are identified by their snapshot slot (Mesh3D::getBodyId), -1 for
+// none or for bodies of another world.
+namespace Physics {
+    // Collects leaf objects from broadphase trees
+    struct BroadphaseCollector : btDbvt::ICollide {
+        btAlignedObjectArray<const btCollisionObject *> objects;
+        void Process(const btDbvtNode *leaf) override {
+            const btBroadphaseProxy *proxy = static_cast<const btBroadphaseProxy *>(leaf->data);
+            objects.push_back(static_cast<const btCollisionObject *>(proxy->m_clientObject));
+        }
+    };
+
+    // Parked bodies (PhysicsManager) collide with nothing
+    inline bool isParked(const btCollisionObject *object) {
+        const btBroadphaseProxy *proxy = object->getBroadphaseHandle();
+        return !proxy || proxy->m_collisionFilterGroup == 0;
+    }
+
+    struct SweepHit {
+        bool hit = false;
+        btScalar fraction = 1;
+        btVector3 point{0, 0, 0};
+        btVector3 normal{0, 0, 0}; // away from the surface, against the sweep
+        const btCollisionObject *object = nullptr;
+    };
+
+    // Closest hit of shape moved from one transform to another, skipping
+    // parked bodies and any object skip(object) is true for. Surfaces the
+    // shape moves away from don't count, so a sweep starting in contact
+    // can always back off. Safe to run concurrently while the world isn't
+    // stepping (the world must use a btDbvtBroadphase, see PhysicsWorld).
+    template<typename Skip>
+    inline SweepHit sweep(btCollisionWorld *world, const btConvexShape *shape,
+                          const btTransform &from, const btTransform &to, Skip &&skip) {
+        struct Closest : btCollisionWorld::ClosestConvexResultCallback {
+            btVector3 direction;
+            Closest(const btVector3 &from, const btVector3 &to)
+                : ClosestConvexResultCallback(from, to), direction(to - from) {}
+
+            btScalar addSingleResult(btCollisionWorld::LocalConvexResult &result, bool normalInWorldSpace) override {
+                btVector3 normal = normalInWorldSpace
+                    ? result.m_hitNormalLocal
+                    : result.m_hitCollisionObject->getWorldTransform().getBasis() * result.m_hitNormalLocal;
+                if (normal.dot(direction) > 0) return 1;
+                return ClosestConvexResultCallback::addSingleResult(result, normalInWorldSpace);
+            }
+        };
+
+        btVector3 minA, maxA, minB, maxB;
+        shape->getAabb(from, minA, maxA);
+        shape->getAabb(to, minB, maxB);
+        minA.setMin(minB);
+        maxA.setMax(maxB);
+        btDbvtVolume bounds = btDbvtVolume::FromMM(minA, maxA);
+
+        BroadphaseCollector collector;
+        btDbvtBroadphase *broadphase = static_cast<btDbvtBroadphase *>(world->getBroadphase());
+        for (btDbvt &tree : broadphase->m_sets) {
+            tree.collideTV(tree.m_root, bounds, collector);
+        }
+
+        Closest result(from.getOrigin(), to.getOrigin());
+        for (int i = 0; i < collector.objects.size(); i++) {
+            const btCollisionObject *object = collector.objects[i];
+            if (isParked(object) || skip(object)) continue;
+            btCollisionWorld::objectQuerySingle(shape, from, to, const_cast<btCollisionObject *>(object),
+                                                object->getCollisionShape(), object->getWorldTransform(), result, 0);
+        }
+
+        SweepHit hit;
+        if (!result.hasHit()) return hit;
+        hit.hit = true;
+        hit.fraction = result.m_closestHitFraction;
+        hit.point = result.m_hitPointWorld;
+        hit.normal = result.m_hitNormalWorld;
+        hit.object = result.m_hitCollisionObject;
+        return hit;
+    }
+
+    class QueryBatch {
+    public:
+        enum Type {
+            RAY,
+            SPHERE_SWEEP,
+            CAPSULE_SWEEP,
+            SPHERE_OVERLAP,
+            CAPSULE_OVERLAP
+        };
+
+        enum Status {
+            IDLE,    // being filled, results (if any) from the last run
+            PENDING, // submitted, owned by the physics thread
+            READY    // results valid
+        };
+
+        struct Query {
+            Type type = RAY;
+            btVector3 from{0, 0, 0};
+            btVector3 to{0, 0, 0};   // same as from for overlaps
+            btScalar radius = 0;
+            btScalar height = 0;     // capsule cylinder part, Y up
+            int ignore = -1;         // body never reported, usually the caster
+        };
+
+        // One entry per query, in the order they were added. Sweeps and rays
+        // report the closest hit; overlaps report the first body in hit/body
+        // and every body in overlapBodies[overlapStart[i] .. +overlapCount[i]].
+        std::vector<uint8_t> hit;
+        std::vector<float> fraction; // along from..to, 1 without a hit
+        std::vector<btVector3> point;
+        std::vector<btVector3> normal;
+        std::vector<int> body;
+        std::vector<int> overlapStart;
+        std::vector<int> overlapCount;
+        std::vector<int> overlapBodies;
+
+        // Each returns the query's index
+        int addRay(const btVector3 &from, const btVector3 &to, int ignore = -1) {
+            return add({RAY, from, to, 0, 0, ignore});
+        }
+        int addSphereSweep(const btVector3 &from, const btVector3 &to, btScalar radius, int ignore = -1) {
+            return add({SPHERE_SWEEP, from, to, radius, 0, ignore});
+        }
+        int addCapsuleSweep(const btVector3 &from, const btVector3 &to, btScalar radius, btScalar height, int ignore = -1) {
+            return add({CAPSULE_SWEEP, from, to, radius, height, ignore});
+        }
+        int addSphereOverlap(const btVector3 &center, btScalar radius, int ignore = -1) {
+            return add({SPHERE_OVERLAP, center, center, radius, 0, ignore});
+        }
+        int addCapsuleOverlap(const btVector3 &center, btScalar radius, btScalar height, int ignore = -1) {
+            return add({CAPSULE_OVERLAP, center, center, radius, height, ignore});
+        }
+
+        // Drops queries and results so the batch can be refilled
+        void clear() {
+            checkIdle();
+            queries.clear();
+            clearResults();
+            status.store(IDLE, std::memory_order_relaxed);
+        }
+
+        int size() const { return (int)queries.size(); }
+        Status getStatus() const { return status.load(std::memory_order_acquire); }
+        bool isPending() const { return getStatus() == PENDING; }
+        bool isReady() const { return getStatus() == READY; }
+
+        // Call before reading the result vectors: while pending the physics
+        // thread is refilling them
+        void checkReadable() const {
+            if (getStatus() == PENDING)
+                throw std::runtime_error("QueryBatch: results read while the physics thread owns it");
+        }
+
+        // PhysicsManager only
+        void markPending() {
+            checkIdle();
+            status.store(PENDING, std::memory_order_relaxed);
+        }
+
+        // The world went away before running it
+        void cancel() {
+            clearResults();
+            status.store(IDLE, std::memory_order_release);
+        }
+
+        // Physics thread, world not stepping. owner filters out bodies of
+        // other managers.
+        void execute(btCollisionWorld *world, const SharedState *owner) {
+            size_t count = queries.size();
+            hit.assign(count, 0);
+            fraction.assign(count, 1.0f);
+            point.assign(count, btVector3(0, 0, 0));
+            normal.assign(count, btVector3(0, 0, 0));
+            body.assign(count, -1);
+            overlapStart.assign(count, 0);
+            overlapCount.assign(count, 0);
+            overlapBodies.clear();
+
+            std::vector<std::vector<int>> overlaps(count);
+
+            Jobs::parallelFor(count, [&](size_t i) {
+                Context context{world, owner, queries[i], i, overlaps[i]};
+                switch (queries[i].type) {
+                    case RAY:
+                        runRay(context);
+                        break;
+                    case SPHERE_SWEEP:
+                    case CAPSULE_SWEEP:
+                        runSweep(context);
+                        break;
+                    case SPHERE_OVERLAP:
+                    case CAPSULE_OVERLAP:
+                        runOverlap(context);
+                        break;
+                }
+            });
+
+            for (size_t i = 0; i < count; i++) {
+                overlapStart[i] = (int)overlapBodies.size();
+                overlapCount[i] = (int)overlaps[i].size();
+                overlapBodies.insert(overlapBodies.end(), overlaps[i].begin(), overlaps[i].end());
+            }
+            status.store(READY, std::memory_order_release);
+        }
+
+    private:
+        std::vector<Query> queries;
+        std::atomic<Status> status{IDLE};
+
+        struct Context {
+            btCollisionWorld *world;
+            const SharedState *owner;
+            const Query &query;
+            size_t index;
+            std::vector<int> &overlaps;
+
+            int idOf(const btCollisionObject *object) const {
+                return sharedStateOf(object) == owner ? object->getUserIndex() : -1;
+            }
+            bool skip(const btCollisionObject *object) const {
+                if (isParked(object)) return true;
+                return query.ignore >= 0 && idOf(object) == query.ignore;
+            }
+            btDbvtBroadphase *broadphase() const {
+                return static_cast<btDbvtBroadphase *>(world->getBroadphase());
+            }
+        };
+
+        int add(const Query &query) {
+            checkIdle();
+            if (status.load(std::memory_order_relaxed) == READY) {
+                // first add after reading: start a new batch
+                queries.clear();
+                clearResults();
+                status.store(IDLE, std::memory_order_relaxed);
+            }
+            queries.push_back(query);
+            return (int)queries.size() - 1;
+        }
+
+        void checkIdle() const {
+            if (status.load(std::memory_order_acquire) == PENDING)
+                throw std::runtime_error("QueryBatch: modified while the physics thread owns it");
+        }
+
+        void clearResults() {
+            hit.clear();
+            fraction.clear();
+            point.clear();
+            normal.clear();
+            body.clear();
+            overlapStart.clear();
+            overlapCount.clear();
+            overlapBodies.clear();
+        }
+
+        static std::unique_ptr<btConvexShape> shapeOf(const Query &query) {
+            if (query.type == CAPSULE_SWEEP || query.type == CAPSULE_OVERLAP)
+                return std::make_unique<btCapsuleShape>(query.radius, query.height);
+            return std::make_unique<btSphereShape>(query.radius);
+        }
+
+        static btTransform transformAt(const btVector3 &origin) {
+            btTransform transform;
+            transform.setIdentity();
+            transform.setOrigin(origin);
+            return transform;
+        }
+
+        void runRay(Context &context) {
+            const Query &query = context.query;
+            // both broadphase trees: moving and static proxies
+            BroadphaseCollector collector;
+            for (btDbvt &tree : context.broadphase()->m_sets) {
+                btDbvt::rayTest(tree.m_root, query.from, query.to, collector);
+            }
+
+            btCollisionWorld::ClosestRayResultCallback result(query.from, query.to);
+            btTransform from = transformAt(query.from);
+            btTransform to = transformAt(query.to);
+            for (int i = 0; i < collector.objects.size(); i++) {
+                const btCollisionObject *object = collector.objects[i];
+                if (context.skip(object)) continue;
+                btCollisionWorld::rayTestSingle(from, to, const_cast<btCollisionObject *>(object),
+                                                object->getCollisionShape(), object->getWorldTransform(), result);
+            }
+            if (!result.hasHit()) return;
+            store(context.index, result.m_closestHitFraction, result.m_hitPointWorld,
+                  result.m_hitNormalWorld, context.idOf(result.m_collisionObject));
+        }
+
+        void runSweep(Context &context) {
+            const Query &query = context.query;
+            std::unique_ptr<btConvexShape> shape = shapeOf(query);
+            SweepHit result = sweep(context.world, shape.get(), transformAt(query.from), transformAt(query.to),
+                                    [&](const btCollisionObject *object) { return context.skip(object); });
+            if (!result.hit) return;
+            store(context.index, result.fraction, result.point, result.normal, context.idOf(result.object));
+        }
+
+        void runOverlap(Context &context) {
+            const Query &query = context.query;
+            std::unique_ptr<btConvexShape> shape = shapeOf(query);
+            btTransform transform = transformAt(query.from);
+
+            btVector3 min, max;
+            shape->getAabb(transform, min, max);
+            btDbvtVolume bounds = btDbvtVolume::FromMM(min, max);
+
+            BroadphaseCollector collector;
+            for (btDbvt &tree : context.broadphase()->m_sets) {
+                tree.collideTV(tree.m_root, bounds, collector);
+            }
+
+            for (int i = 0; i < collector.objects.size(); i++) {
+                const btCollisionObject *object = collector.objects[i];
+                if (context.skip(object)) continue;
+
+                btVector3 contact, contactNormal;
+                if (!touches(shape.get(), transform, object->getCollisionShape(), object->getWorldTransform(),
+                             contact, contactNormal)) continue;
+
+                int id = context.idOf(object);
+                if (context.overlaps.empty())
+                    store(context.index, 0.0f, contact, contactNormal, id);
+                context.overlaps.push_back(id);
+            }
+        }
+
+        void store(size_t index, btScalar hitFraction, const btVector3 &hitPoint, const btVector3 &hitNormal, int id) {
+            hit[index] = 1;
+            fraction[index] = hitFraction;
+            point[index] = hitPoint;
+            normal[index] = hitNormal;
+            body[index] = id;
+        }
+
+        // GJK between two convex shapes, margins included
+        static bool convexTouches(const btConvexShape *a, const btTransform &ta,
+                                  const btConvexShape *b, const btTransform &tb,
+                                  btVector3 &contact, btVector3 &contactNormal) {
+            btVoronoiSimplexSolver simplex;
+            btGjkEpaPenetrationDepthSolver penetration;
+            btGjkPairDetector detector(a, b, &simplex, &penetration);
+
+            btGjkPairDetector::ClosestPointInput input;
+            input.m_transformA = ta;
+            input.m_transformB = tb;
+            btPointCollector output;
+            detector.getClosestPoints(input, output, nullptr);
+
+            if (!output.m_hasResult || output.m_distance > 0) return false;
+            contact = output.m_pointInWorld;
+            contactNormal = output.m_normalOnBInWorld;
+            return true;
+        }
+
+        // Query shape against any body shape: convex directly, compounds per
+        // child, concave meshes (and planes) per triangle inside the query's
+        // bounds
+        static bool touches(const btConvexShape *shape, const btTransform &transform,
+                            const btCollisionShape *other, const btTransform &otherTransform,
+                            btVector3 &contact, btVector3 &contactNormal) {
+            if (other->isConvex()) {
+                return convexTouches(shape, transform, static_cast<const btConvexShape *>(other), otherTransform,
+                                     contact, contactNormal);
+            }
+
+            if (other->isCompound()) {
+                const btCompoundShape *compound = static_cast<const btCompoundShape *>(other);
+                for (int i = 0; i < compound->getNumChildShapes(); i++) {
+                    if (touches(shape, transform, compound->getChildShape(i),
+                                otherTransform * compound->getChildTransform(i), contact, contactNormal))
+                        return true;
+                }
+                return false;
+            }
+
+            if (!other->isConcave()) return false;
+
+            struct TriangleTest : btTriangleCallback {
+                const btConvexShape *shape;
+                btTransform transform;
+                btTransform otherTransform;
+                btVector3 contact{0, 0, 0};
+                btVector3 contactNormal{0, 0, 0};
+                bool found = false;
+
+                void processTriangle(btVector3 *triangle, int, int) override {
+                    if (found) return;
+                    btTriangleShape triangleShape(triangle[0], triangle[1], triangle[2]);
+                    triangleShape.setMargin(0);
+                    found = convexTouches(shape, transform, &triangleShape, otherTransform, contact, contactNormal);
+                }
+            };
+
+            TriangleTest test;
+            test.shape = shape;
+            test.transform = transform;
+            test.otherTransform = otherTransform;
+
+            // triangles come in the mesh's local space
+            btVector3 min, max;
+            shape->getAabb(otherTransform.inverse() * transform, min, max);
+            static_cast<const btConcaveShape *>(other)->processAllTriangles(&test, min, max);
+
+            contact = test.contact;
+            contactNormal = test.contactNormal;
+            return test.found;
+        }
+    };
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "btBulletDynamicsCommon.h"
+
+// When a body may stop being simulated. Sleeping bodies cost nothing per
+// step and wake when an active body touches their island or game code
+// changes their velocity.
+enum ActivationPolicy {
+    ACTIVATION_AUTO,    // sleeps once it comes to rest
+    ACTIVATION_ALWAYS,  // never sleeps
+    ACTIVATION_ASLEEP   // starts asleep (settled props), then as AUTO
+};
+
+// State shared between the physics thread (PhysicsManager) and the rest of
+// the engine. Outside the physics thread nothing touches a btRigidBody while
+// the world may be stepping: reads go through the last published snapshot,
+// writes are queued as commands that run before the next step.
+namespace Physics {
+    // One body after the last step, world units. Position and orientation are
+    // already interpolated for rendering.
+    struct BodyState {
+        glm::vec3 position{0.0f};
+        glm::quat orientation{1.0f, 0.0f, 0.0f, 0.0f};
+        glm::vec3 linearVelocity{0.0f};
+        // physics units, same as btRigidBody::getAabb
+        glm::vec3 aabbMin{0.0f};
+        glm::vec3 aabbMax{0.0f};
+        bool sleeping = false;
+        bool grounded = false; // character controllers: on walkable ground
+        bool valid = false;
+    };
+
+    struct Snapshot {
+        std::vector<BodyState> bodies; // indexed by the body's user index
+        std::vector<int> moved;        // slots written by this publish
+        bool cameraGrounded = false;
+    };
+
+    using Command = std::function<void()>;
+
+    // Physics thread, or before the body is registered
+    inline void applyActivationPolicy(btRigidBody *body, ActivationPolicy policy) {
+        if (body->isStaticObject()) return;
+        switch (policy) {
+            case ACTIVATION_ALWAYS:
+                body->forceActivationState(DISABLE_DEACTIVATION);
+                break;
+            case ACTIVATION_ASLEEP:
+                body->forceActivationState(ISLAND_SLEEPING);
+                break;
+            case ACTIVATION_AUTO:
+                body->forceActivationState(ACTIVE_TAG);
+                body->setDeactivationTime(0.0f);
+                break;
+        }
+    }
+
+    // One per PhysicsManager; registered bodies point at it through their
+    // user pointer, so a scene being loaded never mixes with the old one.
+    struct SharedState {
+        // Written alternately by the physics thread; `published` is the one it
+        // finished last. The main thread pins it into readIndex only while the
+        // physics thread is idle, so the writer never touches the pinned one
+        // and reads need no lock.
+        std::array<Snapshot, 2> snapshots;
+        std::atomic<int> published{0};
+        int readIndex = 0;
+
+        std::mutex commandMutex;
+        std::vector<Command> pendingCommands;
+
+        const Snapshot &current() const {
+            return snapshots[readIndex];
+        }
+    };
+
+    inline SharedState *sharedStateOf(const btCollisionObject *body) {
+        return static_cast<SharedState *>(body->getUserPointer());
+    }
+
+    // Null until the body has been through a step
+    inline const BodyState *state(const btCollisionObject *body) {
+        SharedState *shared = sharedStateOf(body);
+        if (!shared) return nullptr;
+        int slot = body->getUserIndex();
+        const std::vector<BodyState> &bodies = shared->current().bodies;
+        if (slot < 0 || slot >= (int)bodies.size() || !bodies[slot].valid) return nullptr;
+        return &bodies[slot];
+    }
+
+    // Runs command on the physics thread before its next step, in queue
+    // order. Bodies not registered with a world yet are only touched by
+    // the main thread, so the command runs right away.
+    inline void enqueue(btCollisionObject *body, Command command) {
+        SharedState *shared = sharedStateOf(body);
+        if (!shared) {
+            command();
+            return;
+        }
+        std::lock_guard<std::mutex> lock(shared->commandMutex);
+        shared->pendingCommands.push_back(std::move(command));
+    }
+}
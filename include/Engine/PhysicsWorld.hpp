@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "btBulletDynamicsCommon.h"
+
+#ifdef VORPAL_PHYSICS_MT
+#include "LinearMath/btThreads.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#endif
+
+#include "config.h"
+
+// Bullet world construction, kept free of engine/Vulkan headers so the
+// physics benchmark builds the exact same world as PhysicsManager.
+//
+// With VORPAL_PHYSICS_MT (CMake option, builds Bullet with BT_THREADSAFE)
+// collision dispatch, island solving and integration run on Bullet's task
+// scheduler through the Mt world, dispatcher and solver pool; otherwise
+// this is the plain single-threaded world.
+namespace Physics {
+    // Worker count Bullet's scheduler should use; PHYSICS_THREADS 0 takes
+    // every core but the one running the physics thread itself.
+    inline int defaultThreadCount() {
+        if (PHYSICS_THREADS > 0) return PHYSICS_THREADS;
+        return (int)std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+
+    // Bullet's scheduler is process global; created once, resizable later
+    inline void setThreadCount(int threads) {
+#ifdef VORPAL_PHYSICS_MT
+        static std::once_flag created;
+        std::call_once(created, [] {
+            btSetTaskScheduler(btCreateDefaultTaskScheduler());
+        });
+        btITaskScheduler *scheduler = btGetTaskScheduler();
+        scheduler->setNumThreads(std::clamp(threads, 1, scheduler->getMaxNumThreads()));
+#else
+        (void)threads;
+#endif
+    }
+
+    inline int getThreadCount() {
+#ifdef VORPAL_PHYSICS_MT
+        btITaskScheduler *scheduler = btGetTaskScheduler();
+        return scheduler ? scheduler->getNumThreads() : 1;
+#else
+        return 1;
+#endif
+    }
+
+    struct World {
+        std::unique_ptr<btDefaultCollisionConfiguration> collisionConfiguration;
+        std::unique_ptr<btCollisionDispatcher> dispatcher;
+        std::unique_ptr<btBroadphaseInterface> overlappingPairCache;
+        std::unique_ptr<btConstraintSolver> solver;
+#ifdef VORPAL_PHYSICS_MT
+        std::unique_ptr<btConstraintSolverPoolMt> solverPool;
+#endif
+        std::shared_ptr<btDiscreteDynamicsWorld> dynamicsWorld;
+
+        void create() {
+            collisionConfiguration = std::make_unique<btDefaultCollisionConfiguration>();
+            overlappingPairCache = std::make_unique<btDbvtBroadphase>();
+
+#ifdef VORPAL_PHYSICS_MT
+            if (!btGetTaskScheduler()) setThreadCount(defaultThreadCount());
+
+            dispatcher = std::make_unique<btCollisionDispatcherMt>(collisionConfiguration.get());
+            solverPool = std::make_unique<btConstraintSolverPoolMt>(BT_MAX_THREAD_COUNT);
+            solver = std::make_unique<btSequentialImpulseConstraintSolverMt>();
+
+            dynamicsWorld = std::make_shared<btDiscreteDynamicsWorldMt>(
+                dispatcher.get(),
+                overlappingPairCache.get(),
+                solverPool.get(),
+                solver.get(),
+                collisionConfiguration.get()
+            );
+#else
+            dispatcher = std::make_unique<btCollisionDispatcher>(collisionConfiguration.get());
+            solver = std::make_unique<btSequentialImpulseConstraintSolver>();
+
+            dynamicsWorld = std::make_shared<btDiscreteDynamicsWorld>(
+                dispatcher.get(),
+                overlappingPairCache.get(),
+                solver.get(),
+                collisionConfiguration.get()
+            );
+#endif
+
+            dynamicsWorld->setGravity(btVector3(0, -9.81f, 0));
+            // only active bodies refresh their broadphase AABB, so a scene at
+            // rest costs next to nothing; static bodies never move here
+            dynamicsWorld->setForceUpdateAllAabbs(false);
+        }
+
+        // The world has to go before the parts it references
+        ~World() {
+            dynamicsWorld.reset();
+        }
+    };
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define VORPAL_POSE_SSE 1
+#endif
+
+// Affine transform stored as its top three rows: [rotation*scale | translation].
+// The skinned shaders read it as a mat3x4 and transform with vec4(p, 1) * m,
+// so a palette entry is 48 bytes instead of a full mat4's 64.
+struct alignas(16) Affine3x4 {
+    float m[3][4];
+};
+
+// Joint local transforms as structure-of-arrays, padded with identity joints
+// to a multiple of four so conversion always runs on whole SIMD lanes.
+struct PoseSoA {
+    std::vector<float> tx, ty, tz;
+    std::vector<float> qx, qy, qz, qw;
+    std::vector<float> sx, sy, sz;
+    size_t count = 0;
+
+    size_t padded() const { return tx.size(); }
+
+    void resize(size_t joints) {
+        count = joints;
+        size_t lanes = (joints + 3) & ~size_t(3);
+        for (std::vector<float>* v : {&tx, &ty, &tz, &qx, &qy, &qz}) v->assign(lanes, 0.0f);
+        for (std::vector<float>* v : {&qw, &sx, &sy, &sz}) v->assign(lanes, 1.0f);
+    }
+
+    // Same-sized copy that never reallocates, for per-frame scratch poses
+    void copyFrom(const PoseSoA& other) {
+        std::copy(other.tx.begin(), other.tx.end(), tx.begin());
+        std::copy(other.ty.begin(), other.ty.end(), ty.begin());
+        std::copy(other.tz.begin(), other.tz.end(), tz.begin());
+        std::copy(other.qx.begin(), other.qx.end(), qx.begin());
+        std::copy(other.qy.begin(), other.qy.end(), qy.begin());
+        std::copy(other.qz.begin(), other.qz.end(), qz.begin());
+        std::copy(other.qw.begin(), other.qw.end(), qw.begin());
+        std::copy(other.sx.begin(), other.sx.end(), sx.begin());
+        std::copy(other.sy.begin(), other.sy.end(), sy.begin());
+        std::copy(other.sz.begin(), other.sz.end(), sz.begin());
+    }
+
+    void setTranslation(size_t j, float x, float y, float z) { tx[j] = x; ty[j] = y; tz[j] = z; }
+    void setRotation(size_t j, float x, float y, float z, float w) { qx[j] = x; qy[j] = y; qz[j] = z; qw[j] = w; }
+    void setScale(size_t j, float x, float y, float z) { sx[j] = x; sy[j] = y; sz[j] = z; }
+
+    void setTranslation(size_t j, const glm::vec3& t) { setTranslation(j, t.x, t.y, t.z); }
+    void setRotation(size_t j, const glm::quat& q) { setRotation(j, q.x, q.y, q.z, q.w); }
+    void setScale(size_t j, const glm::vec3& s) { setScale(j, s.x, s.y, s.z); }
+};
+
+namespace PoseMath {
+    inline Affine3x4 identity() {
+        return {{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}}};
+    }
+
+    // Drops the projective row; only valid for affine matrices (glm is column-major)
+    inline Affine3x4 fromMat4(const glm::mat4& mat) {
+        Affine3x4 a;
+        for (int r = 0; r < 3; r++)
+            for (int c = 0; c < 4; c++) a.m[r][c] = mat[c][r];
+        return a;
+    }
+
+    // out = a * b. out may alias either input.
+    inline void concat(const Affine3x4& a, const Affine3x4& b, Affine3x4& out) {
+#ifdef VORPAL_POSE_SSE
+        __m128 b0 = _mm_load_ps(b.m[0]);
+        __m128 b1 = _mm_load_ps(b.m[1]);
+        __m128 b2 = _mm_load_ps(b.m[2]);
+        __m128 a0 = _mm_load_ps(a.m[0]);
+        __m128 a1 = _mm_load_ps(a.m[1]);
+        __m128 a2 = _mm_load_ps(a.m[2]);
+        // implicit fourth row of b is (0, 0, 0, 1)
+        const __m128 unitW = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+        auto row = [&](__m128 ar) {
+            __m128 r = _mm_mul_ps(_mm_shuffle_ps(ar, ar, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(ar, ar, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(ar, ar, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+            return _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(ar, ar, _MM_SHUFFLE(3, 3, 3, 3)), unitW));
+        };
+        _mm_store_ps(out.m[0], row(a0));
+        _mm_store_ps(out.m[1], row(a1));
+        _mm_store_ps(out.m[2], row(a2));
+#else
+        Affine3x4 r;
+        for (int i = 0; i < 3; i++) {
+            for (int c = 0; c < 4; c++)
+                r.m[i][c] = a.m[i][0] * b.m[0][c] + a.m[i][1] * b.m[1][c] + a.m[i][2] * b.m[2][c];
+            r.m[i][3] += a.m[i][3];
+        }
+        out = r;
+#endif
+    }
+
+    // dst = mix(dst, src, weight * mask[j]) for every joint; rotations use a
+    // normalized lerp along the shorter arc. mask may be null (all joints).
+    // Branch-free over the SoA streams so the compiler can vectorize it.
+    inline void blend(PoseSoA& dst, const PoseSoA& src, float weight, const float* mask) {
+        for (size_t j = 0; j < dst.padded(); j++) {
+            float w = mask ? weight * mask[j] : weight;
+            float k = 1.0f - w;
+            dst.tx[j] = dst.tx[j] * k + src.tx[j] * w;
+            dst.ty[j] = dst.ty[j] * k + src.ty[j] * w;
+            dst.tz[j] = dst.tz[j] * k + src.tz[j] * w;
+            dst.sx[j] = dst.sx[j] * k + src.sx[j] * w;
+            dst.sy[j] = dst.sy[j] * k + src.sy[j] * w;
+            dst.sz[j] = dst.sz[j] * k + src.sz[j] * w;
+
+            float d = dst.qx[j] * src.qx[j] + dst.qy[j] * src.qy[j] + dst.qz[j] * src.qz[j] + dst.qw[j] * src.qw[j];
+            float ws = d < 0.0f ? -w : w;
+            float x = dst.qx[j] * k + src.qx[j] * ws;
+            float y = dst.qy[j] * k + src.qy[j] * ws;
+            float z = dst.qz[j] * k + src.qz[j] * ws;
+            float q = dst.qw[j] * k + src.qw[j] * ws;
+            float inv = 1.0f / std::sqrt(std::max(x * x + y * y + z * z + q * q, 1e-12f));
+            dst.qx[j] = x * inv; dst.qy[j] = y * inv; dst.qz[j] = z * inv; dst.qw[j] = q * inv;
+        }
+    }
+
+    // Layers src on top of dst as a difference from ref, scaled by
+    // weight * mask[j]: translation offset, rotation ref^-1 * src applied in
+    // joint space, and scale ratio.
+    inline void addDelta(PoseSoA& dst, const PoseSoA& src, const PoseSoA& ref, float weight, const float* mask) {
+        for (size_t j = 0; j < dst.padded(); j++) {
+            float w = mask ? weight * mask[j] : weight;
+            dst.tx[j] += (src.tx[j] - ref.tx[j]) * w;
+            dst.ty[j] += (src.ty[j] - ref.ty[j]) * w;
+            dst.tz[j] += (src.tz[j] - ref.tz[j]) * w;
+            dst.sx[j] *= 1.0f + (ref.sx[j] != 0.0f ? src.sx[j] / ref.sx[j] - 1.0f : 0.0f) * w;
+            dst.sy[j] *= 1.0f + (ref.sy[j] != 0.0f ? src.sy[j] / ref.sy[j] - 1.0f : 0.0f) * w;
+            dst.sz[j] *= 1.0f + (ref.sz[j] != 0.0f ? src.sz[j] / ref.sz[j] - 1.0f : 0.0f) * w;
+
+            // delta = conjugate(ref) * src
+            float rx = -ref.qx[j], ry = -ref.qy[j], rz = -ref.qz[j], rw = ref.qw[j];
+            float sx = src.qx[j], sy = src.qy[j], sz = src.qz[j], sw = src.qw[j];
+            float dx = rw * sx + rx * sw + ry * sz - rz * sy;
+            float dy = rw * sy - rx * sz + ry * sw + rz * sx;
+            float dz = rw * sz + rx * sy - ry * sx + rz * sw;
+            float dw = rw * sw - rx * sx - ry * sy - rz * sz;
+
+            // nlerp from identity by w, on the shorter arc
+            float ws = dw < 0.0f ? -w : w;
+            dx *= ws; dy *= ws; dz *= ws; dw = (1.0f - w) + dw * ws;
+            float inv = 1.0f / std::sqrt(std::max(dx * dx + dy * dy + dz * dz + dw * dw, 1e-12f));
+            dx *= inv; dy *= inv; dz *= inv; dw *= inv;
+
+            // dst = dst * delta
+            float ax = dst.qx[j], ay = dst.qy[j], az = dst.qz[j], aw = dst.qw[j];
+            dst.qx[j] = aw * dx + ax * dw + ay * dz - az * dy;
+            dst.qy[j] = aw * dy - ax * dz + ay * dw + az * dx;
+            dst.qz[j] = aw * dz + ax * dy - ay * dx + az * dw;
+            dst.qw[j] = aw * dw - ax * dx - ay * dy - az * dz;
+        }
+    }
+
+    // T * R * S for every joint of the pose, four joints per iteration.
+    // out must hold pose.padded() entries.
+    inline void toAffine(const PoseSoA& pose, Affine3x4* out) {
+#ifdef VORPAL_POSE_SSE
+        const __m128 one = _mm_set1_ps(1.0f);
+        for (size_t j = 0; j < pose.padded(); j += 4) {
+            __m128 x = _mm_loadu_ps(&pose.qx[j]), y = _mm_loadu_ps(&pose.qy[j]);
+            __m128 z = _mm_loadu_ps(&pose.qz[j]), w = _mm_loadu_ps(&pose.qw[j]);
+            __m128 x2 = _mm_add_ps(x, x), y2 = _mm_add_ps(y, y), z2 = _mm_add_ps(z, z);
+
+            __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+            __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+            __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+
+            __m128 sx = _mm_loadu_ps(&pose.sx[j]), sy = _mm_loadu_ps(&pose.sy[j]), sz = _mm_loadu_ps(&pose.sz[j]);
+
+            // rows of R, each column scaled by S
+            __m128 r0 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx);
+            __m128 r1 = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+            __m128 r2 = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+            __m128 r3 = _mm_loadu_ps(&pose.tx[j]);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_store_ps(out[j].m[0], r0);
+            _mm_store_ps(out[j + 1].m[0], r1);
+            _mm_store_ps(out[j + 2].m[0], r2);
+            _mm_store_ps(out[j + 3].m[0], r3);
+
+            r0 = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+            r1 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy);
+            r2 = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+            r3 = _mm_loadu_ps(&pose.ty[j]);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_store_ps(out[j].m[1], r0);
+            _mm_store_ps(out[j + 1].m[1], r1);
+            _mm_store_ps(out[j + 2].m[1], r2);
+            _mm_store_ps(out[j + 3].m[1], r3);
+
+            r0 = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+            r1 = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+            r2 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz);
+            r3 = _mm_loadu_ps(&pose.tz[j]);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_store_ps(out[j].m[2], r0);
+            _mm_store_ps(out[j + 1].m[2], r1);
+            _mm_store_ps(out[j + 2].m[2], r2);
+            _mm_store_ps(out[j + 3].m[2], r3);
+        }
+#else
+        for (size_t j = 0; j < pose.padded(); j++) {
+            float x = pose.qx[j], y = pose.qy[j], z = pose.qz[j], w = pose.qw[j];
+            float xx = 2 * x * x, yy = 2 * y * y, zz = 2 * z * z;
+            float xy = 2 * x * y, xz = 2 * x * z, yz = 2 * y * z;
+            float wx = 2 * w * x, wy = 2 * w * y, wz = 2 * w * z;
+            float sx = pose.sx[j], sy = pose.sy[j], sz = pose.sz[j];
+            out[j] = {{{(1 - yy - zz) * sx, (xy - wz) * sy, (xz + wy) * sz, pose.tx[j]},
+                       {(xy + wz) * sx, (1 - xx - zz) * sy, (yz - wx) * sz, pose.ty[j]},
+                       {(xz - wy) * sx, (yz + wx) * sy, (1 - xx - yy) * sz, pose.tz[j]}}};
+        }
+#endif
+    }
+};
@@ -33,6 +33,11 @@
 #include "Engine/Scene.hpp"
 #include "Engine/PhysicsManager.hpp"
 #include "VK/Validation.hpp"
+#include "VK/PipelineCache.hpp"
+#include "VK/ShaderCache.hpp"
+#include "VK/ShaderVariants.hpp"
+#include "VK/SkinningPass.hpp"
+#include "Engine/JobSystem.hpp"
 
 // waylandTests
 //#include "Engine/WindowSystem.hpp"
@@ -124,18 +129,11 @@ public:
     VkPipelineLayout shadowPipelineLayout;
 
     // WIP dual pipeline
-    VkPipeline pipeline3D;
+    // main-pass pipelines live in ShaderVariants::pipelines, one per material feature set
     VkPipeline skyboxPipeline;
     VkPipeline uiPipeline;
     VkPipeline shadowPipeline;
 
-    // Skeletal animation pipelines
-    VkDescriptorSetLayout boneDescriptorSetLayout;
-    VkPipelineLayout skinnedPipelineLayout;
-    VkPipeline skinnedPipeline;
-    VkPipelineLayout shadowSkinnedPipelineLayout;
-    VkPipeline shadowSkinnedPipeline;
-
     VkImage colorImage;
     VkDeviceMemory colorImageMemory;
     VkImageView colorImageView;
@@ -178,6 +176,12 @@ public:
     // render settings
     bool enable_multisample = true;
     bool enable_vsync = true;
+    int shadowPCFRadius = SHADOW_PCF_RADIUS;
+
+    // reused every frame to sort skinned draws by pipeline variant
+    std::vector<SkinnedMesh3D*> skinnedDrawList;
+    std::vector<SkinnedMesh3D*> animatedMeshes;
+    uint64_t animFrame = 0;
 
     void recreateRender(bool multisample) {
         vkDeviceWaitIdle(VK::device);   
@@ -187,13 +191,14 @@ public:
         // cleanup imgui
         ImGui_ImplVulkan_Shutdown();
         ImGui::DestroyContext();
-        // setup ImGui
-        initImGui();
 
-        vkDestroyPipeline(VK::device, pipeline3D, nullptr);
+        // everything drawn in the main/ui pass depends on the sample count
+        destroyVariantPipelines();
         vkDestroyPipeline(VK::device, skyboxPipeline, nullptr);
+        vkDestroyPipeline(VK::device, uiPipeline, nullptr);
         vkDestroyPipelineLayout(VK::device, pipelineLayout, nullptr);
         vkDestroyPipelineLayout(VK::device, skyboxPipelineLayout, nullptr);
+        vkDestroyPipelineLayout(VK::device, uiPipelineLayout, nullptr);
 
         vkDestroyRenderPass(VK::device, renderPass, nullptr);
         vkDestroyRenderPass(VK::device, uiRenderPass, nullptr);
@@ -203,9 +208,66 @@ public:
 
         recreateSwapChain();
 
-        pipeline3D = createGraphicsPipeline(pipelineLayout, "assets/shaders/vert.spv", "assets/shaders/frag.spv", true, true);
-        skyboxPipeline = createGraphicsPipeline(skyboxPipelineLayout, "assets/shaders/sky.vert.spv", "assets/shaders/sky.frag.spv", false, false);
-        uiPipeline = createGraphicsPipeline(skyboxPipelineLayout, "assets/shaders/vert.spv", "assets/shaders/ui.frag.spv", true, true);
+        // setup ImGui
+        initImGui();
+
+        createPipelines(false);
+    }
+
+    // Builds the independent pipelines on the job pool. They only read
+    // renderer state and the pipeline cache is internally synchronized.
+    void createPipelines(bool includeShadow) {
+        // the first variant creates the shared layout
+        std::vector<std::function<void()>> builds = {
+            [&]() { buildVariantPipeline(0, false); },
+            [&]() { skyboxPipeline = createGraphicsPipeline(skyboxPipelineLayout, "assets/shaders/sky.vert.spv", "assets/shaders/sky.frag.spv", false, false); },
+            [&]() { uiPipeline = createGraphicsPipeline(uiPipelineLayout, "assets/shaders/vert.spv", "assets/shaders/ui.frag.spv", true, true); },
+        };
+        if (includeShadow) {
+            builds.push_back([&]() { shadowPipeline = createShadowPipeline(shadowPipelineLayout, "assets/shaders/shadow.vert.spv"); });
+        }
+        runPipelineBuilds(builds);
+
+        std::vector<std::function<void()>> variants;
+        for (uint32_t features = 1; features < MATERIAL_VARIANT_COUNT; features++) {
+            variants.push_back([this, features]() { buildVariantPipeline(features, true); });
+        }
+        runPipelineBuilds(variants);
+
+        PipelineCache::save();
+    }
+
+    void runPipelineBuilds(std::vector<std::function<void()>> &builds) {
+        std::vector<std::exception_ptr> errors(builds.size());
+        Jobs::parallelFor(builds.size(), [&](size_t i) {
+            try {
+                builds[i]();
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+        for (auto &error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+    }
+
+    void buildVariantPipeline(uint32_t features, bool reuseLayout) {
+        ShaderVariants::SpecializationData data = ShaderVariants::specializationFor(features, shadowPCFRadius);
+
+        VkSpecializationInfo specialization{};
+        specialization.mapEntryCount = (uint32_t)ShaderVariants::mapEntries.size();
+        specialization.pMapEntries = ShaderVariants::mapEntries.data();
+        specialization.dataSize = sizeof(data);
+        specialization.pData = &data;
+
+        ShaderVariants::pipelines[features] = createGraphicsPipeline(pipelineLayout, "assets/shaders/vert.spv", "assets/shaders/frag.spv", true, true, &specialization, reuseLayout);
+    }
+
+    void destroyVariantPipelines() {
+        for (VkPipeline &pipeline : ShaderVariants::pipelines) {
+            vkDestroyPipeline(VK::device, pipeline, nullptr);
+            pipeline = VK_NULL_HANDLE;
+        }
     }
 
     void ImGuiTheme() {
@@ -227,7 +289,7 @@ public:
         init_info.QueueFamily = findQueueFamilies(VK::physicalDevice).graphicsFamily.value();
         init_info.RenderPass = uiRenderPass;
         init_info.Queue = VK::graphicsQueue;
-        init_info.PipelineCache = VK_NULL_HANDLE;
+        init_info.PipelineCache = VK::pipelineCache;
         init_info.DescriptorPool = descriptorPool;
         init_info.Subpass = 0;
         init_info.MinImageCount = 2;
@@ -261,6 +323,7 @@ public:
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
+        PipelineCache::init();
 
         createSwapChain(enable_vsync);
         createImageViews();
@@ -285,18 +348,9 @@ public:
         createShadowResources();
         createShadowFramebuffer();
 
-        pipeline3D = createGraphicsPipeline(pipelineLayout, "assets/shaders/vert.spv", "assets/shaders/frag.spv", true, true);
-        skyboxPipeline = createGraphicsPipeline(skyboxPipelineLayout, "assets/shaders/sky.vert.spv", "assets/shaders/sky.frag.spv", false, false);
-        uiPipeline = createGraphicsPipeline(uiPipelineLayout, "assets/shaders/vert.spv", "assets/shaders/ui.frag.spv", true, true);
-        shadowPipeline = createShadowPipeline(shadowPipelineLayout, "assets/shaders/shadow.vert.spv");
-
-        boneDescriptorSetLayout = createBoneDescriptorSetLayout();
-        VK::boneDescriptorSetLayout = boneDescriptorSetLayout;
+        SkinningPass::init();
 
-        skinnedPipeline       = createSkinnedPipeline(skinnedPipelineLayout,
-                                    "assets/shaders/skinned.vert.spv", "assets/shaders/frag.spv");
-        shadowSkinnedPipeline = createShadowSkinnedPipeline(shadowSkinnedPipelineLayout,
-                                    "assets/shaders/shadow_skinned.vert.spv");
+        createPipelines(true);
 
         createDescriptorPool();        
         createSyncObjects();
@@ -345,19 +399,15 @@ public:
         
         cleanupSwapChain();
 
-        vkDestroyPipeline(VK::device, pipeline3D, nullptr);
+        destroyVariantPipelines();
         vkDestroyPipeline(VK::device, skyboxPipeline, nullptr);
         vkDestroyPipeline(VK::device, uiPipeline, nullptr);
         vkDestroyPipeline(VK::device, shadowPipeline, nullptr);
-        vkDestroyPipeline(VK::device, skinnedPipeline, nullptr);
-        vkDestroyPipeline(VK::device, shadowSkinnedPipeline, nullptr);
 
         vkDestroyPipelineLayout(VK::device, pipelineLayout, nullptr);
         vkDestroyPipelineLayout(VK::device, skyboxPipelineLayout, nullptr);
         vkDestroyPipelineLayout(VK::device, uiPipelineLayout, nullptr);
         vkDestroyPipelineLayout(VK::device, shadowPipelineLayout, nullptr);
-        vkDestroyPipelineLayout(VK::device, skinnedPipelineLayout, nullptr);
-        vkDestroyPipelineLayout(VK::device, shadowSkinnedPipelineLayout, nullptr);
 
         vkDestroyFramebuffer(VK::device, shadowFramebuffer, nullptr);
 
@@ -387,6 +437,7 @@ public:
         }
 
         currentScene->destroy();
+        SkinningPass::destroy();
         skybox.destroy();
         
         // texture cleanup
@@ -397,7 +448,6 @@ public:
         vkDestroyDescriptorPool(VK::device, descriptorPool, nullptr);
         vkDestroyDescriptorSetLayout(VK::device, descriptorSetLayout, nullptr);
         vkDestroyDescriptorSetLayout(VK::device, uiDescriptorSetLayout, nullptr);
-        vkDestroyDescriptorSetLayout(VK::device, boneDescriptorSetLayout, nullptr);
 
         for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
             vkDestroySemaphore(VK::device, renderFinishedSemaphores[i], nullptr);
@@ -405,6 +455,11 @@ public:
             vkDestroyFence(VK::device, inFlightFences[i], nullptr);
         }
 
+        // ImGui and any late pipelines may have added to it since startup
+        PipelineCache::save();
+        PipelineCache::destroy();
+        ShaderCache::destroy();
+
         vkDestroyCommandPool(VK::device, VK::commandPool, nullptr);
         vkDestroyDevice(VK::device, nullptr);
 
@@ -969,14 +1024,12 @@ public:
         return resultLayout;
     }
     
-    VkPipeline createGraphicsPipeline(VkPipelineLayout& layout, const char* vertex_path, const char* fragment_path, bool enableDepth, bool enableBlend) {
+    VkPipeline createGraphicsPipeline(VkPipelineLayout& layout, const char* vertex_path, const char* fragment_path, bool enableDepth, bool enableBlend,
+                                      const VkSpecializationInfo* fragSpecialization = nullptr, bool reuseLayout = false) {
         VkPipeline result;
 
-        auto vertShaderCode = Utils::readFileZip(vertex_path);
-        auto fragShaderCode = Utils::readFileZip(fragment_path);
-
-        VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
-        VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
+        VkShaderModule vertShaderModule = ShaderCache::get(vertex_path);
+        VkShaderModule fragShaderModule = ShaderCache::get(fragment_path);
 
         VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
         vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -989,6 +1042,7 @@ public:
         fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
         fragShaderStageInfo.module = fragShaderModule;
         fragShaderStageInfo.pName = "main";
+        fragShaderStageInfo.pSpecializationInfo = fragSpecialization;
 
         VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
 
@@ -1093,7 +1147,7 @@ public:
         pipelineLayoutInfo.pPushConstantRanges = &push_constant;
 	    pipelineLayoutInfo.pushConstantRangeCount = 1;
 
-        if (vkCreatePipelineLayout(VK::device, &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS) {
+        if (!reuseLayout && vkCreatePipelineLayout(VK::device, &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS) {
             throw std::runtime_error("failed to create pipeline layout!");
         }
 
@@ -1117,21 +1171,17 @@ public:
         pipelineInfo.subpass = 0;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-        if (vkCreateGraphicsPipelines(VK::device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &result) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(VK::device, VK::pipelineCache, 1, &pipelineInfo, nullptr, &result) != VK_SUCCESS) {
             throw std::runtime_error("failed to create graphics pipeline!");
         }
 
-        vkDestroyShaderModule(VK::device, fragShaderModule, nullptr);
-        vkDestroyShaderModule(VK::device, vertShaderModule, nullptr);
-
         return result;
     }
 
     VkPipeline createShadowPipeline(VkPipelineLayout& layout, const char* vertex_path) {
         VkPipeline result;
 
-        auto vertShaderCode = Utils::readFileZip(vertex_path);
-        VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
+        VkShaderModule vertShaderModule = ShaderCache::get(vertex_path);
 
         VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
         vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -1231,242 +1281,10 @@ public:
         pipelineInfo.renderPass = shadowRenderPass;
         pipelineInfo.subpass = 0;
 
-        if (vkCreateGraphicsPipelines(VK::device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &result) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(VK::device, VK::pipelineCache, 1, &pipelineInfo, nullptr, &result) != VK_SUCCESS) {
             throw std::runtime_error("failed to create shadow graphics pipeline!");
         }
 
-        vkDestroyShaderModule(VK::device, vertShaderModule, nullptr);
-
-        return result;
-    }
-
-    // Creates the descriptor set layout for set=1 (bone matrices SSBO)
-    VkDescriptorSetLayout createBoneDescriptorSetLayout() {
-        VkDescriptorSetLayoutBinding binding{};
-        binding.binding         = 0;
-        binding.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        binding.descriptorCount = 1;
-        binding.stageFlags      = VK_SHADER_STAGE_VERTEX_BIT;
-
-        VkDescriptorSetLayoutCreateInfo info{};
-        info.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        info.bindingCount = 1;
-        info.pBindings    = &binding;
-
-        VkDescriptorSetLayout layout;
-        if (vkCreateDescriptorSetLayout(VK::device, &info, nullptr, &layout) != VK_SUCCESS)
-            throw std::runtime_error("Failed to create bone descriptor set layout!");
-        return layout;
-    }
-
-    // Full-shading pipeline for skinned meshes (set0 = scene, set1 = bones)
-    VkPipeline createSkinnedPipeline(VkPipelineLayout& layout,
-                                     const char* vertPath, const char* fragPath) {
-        auto vertCode = Utils::readFileZip(vertPath);
-        auto fragCode = Utils::readFileZip(fragPath);
-        VkShaderModule vertMod = createShaderModule(vertCode);
-        VkShaderModule fragMod = createShaderModule(fragCode);
-
-        VkPipelineShaderStageCreateInfo stages[2]{};
-        stages[0].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        stages[0].stage  = VK_SHADER_STAGE_VERTEX_BIT;
-        stages[0].module = vertMod; stages[0].pName = "main";
-        stages[1].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        stages[1].stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
-        stages[1].module = fragMod; stages[1].pName = "main";
-
-        auto binding    = SkinnedVertex::getBindingDescription();
-        auto attributes = SkinnedVertex::getAttributeDescriptions();
-
-        VkPipelineVertexInputStateCreateInfo vertexInput{};
-        vertexInput.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInput.vertexBindingDescriptionCount   = 1;
-        vertexInput.pVertexBindingDescriptions      = &binding;
-        vertexInput.vertexAttributeDescriptionCount = (uint32_t)attributes.size();
-        vertexInput.pVertexAttributeDescriptions    = attributes.data();
-
-        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-        inputAssembly.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-
-        VkPipelineViewportStateCreateInfo viewportState{};
-        viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-        viewportState.viewportCount = 1; viewportState.scissorCount = 1;
-
-        VkPipelineRasterizationStateCreateInfo rasterizer{};
-        rasterizer.sType       = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-        rasterizer.lineWidth   = 1.0f;
-        rasterizer.cullMode    = VK_CULL_MODE_BACK_BIT;
-        rasterizer.frontFace   = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-
-        VkPipelineMultisampleStateCreateInfo multisampling{};
-        multisampling.sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-        multisampling.rasterizationSamples = enable_multisample ? msaaSamples : VK_SAMPLE_COUNT_1_BIT;
-
-        VkPipelineDepthStencilStateCreateInfo depthStencil{};
-        depthStencil.sType            = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-        depthStencil.depthTestEnable  = VK_TRUE;
-        depthStencil.depthWriteEnable = VK_TRUE;
-        depthStencil.depthCompareOp   = VK_COMPARE_OP_LESS;
-
-        VkPipelineColorBlendAttachmentState blendAttach{};
-        blendAttach.colorWriteMask      = VK_COLOR_COMPONENT_R_BIT|VK_COLOR_COMPONENT_G_BIT|VK_COLOR_COMPONENT_B_BIT|VK_COLOR_COMPONENT_A_BIT;
-        blendAttach.blendEnable         = VK_TRUE;
-        blendAttach.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-        blendAttach.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-        blendAttach.colorBlendOp        = VK_BLEND_OP_ADD;
-        blendAttach.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-        blendAttach.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-        blendAttach.alphaBlendOp        = VK_BLEND_OP_ADD;
-
-        VkPipelineColorBlendStateCreateInfo colorBlending{};
-        colorBlending.sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-        colorBlending.attachmentCount = 1;
-        colorBlending.pAttachments    = &blendAttach;
-
-        std::vector<VkDynamicState> dynStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-        VkPipelineDynamicStateCreateInfo dynamicState{};
-        dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-        dynamicState.dynamicStateCount = (uint32_t)dynStates.size();
-        dynamicState.pDynamicStates    = dynStates.data();
-
-        // Two set layouts: set=0 (scene) + set=1 (bones)
-        VkDescriptorSetLayout setLayouts[2] = { descriptorSetLayout, boneDescriptorSetLayout };
-
-        VkPushConstantRange push{};
-        push.offset     = 0;
-        push.size       = sizeof(ModelBufferObject);
-        push.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-        VkPipelineLayoutCreateInfo layoutInfo{};
-        layoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        layoutInfo.setLayoutCount         = 2;
-        layoutInfo.pSetLayouts            = setLayouts;
-        layoutInfo.pushConstantRangeCount = 1;
-        layoutInfo.pPushConstantRanges    = &push;
-
-        if (vkCreatePipelineLayout(VK::device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
-            throw std::runtime_error("Failed to create skinned pipeline layout!");
-
-        VkGraphicsPipelineCreateInfo pipelineInfo{};
-        pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount          = 2;
-        pipelineInfo.pStages             = stages;
-        pipelineInfo.pVertexInputState   = &vertexInput;
-        pipelineInfo.pInputAssemblyState = &inputAssembly;
-        pipelineInfo.pViewportState      = &viewportState;
-        pipelineInfo.pRasterizationState = &rasterizer;
-        pipelineInfo.pMultisampleState   = &multisampling;
-        pipelineInfo.pDepthStencilState  = &depthStencil;
-        pipelineInfo.pColorBlendState    = &colorBlending;
-        pipelineInfo.pDynamicState       = &dynamicState;
-        pipelineInfo.layout              = layout;
-        pipelineInfo.renderPass          = renderPass;
-        pipelineInfo.subpass             = 0;
-
-        VkPipeline result;
-        if (vkCreateGraphicsPipelines(VK::device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &result) != VK_SUCCESS)
-            throw std::runtime_error("Failed to create skinned graphics pipeline!");
-
-        vkDestroyShaderModule(VK::device, fragMod, nullptr);
-        vkDestroyShaderModule(VK::device, vertMod, nullptr);
-        return result;
-    }
-
-    // Depth-only shadow pipeline for skinned meshes
-    VkPipeline createShadowSkinnedPipeline(VkPipelineLayout& layout, const char* vertPath) {
-        auto vertCode = Utils::readFileZip(vertPath);
-        VkShaderModule vertMod = createShaderModule(vertCode);
-
-        VkPipelineShaderStageCreateInfo stage{};
-        stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        stage.stage  = VK_SHADER_STAGE_VERTEX_BIT;
-        stage.module = vertMod; stage.pName = "main";
-
-        auto binding    = SkinnedVertex::getBindingDescription();
-        auto attributes = SkinnedVertex::getAttributeDescriptions();
-
-        VkPipelineVertexInputStateCreateInfo vertexInput{};
-        vertexInput.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInput.vertexBindingDescriptionCount   = 1;
-        vertexInput.pVertexBindingDescriptions      = &binding;
-        vertexInput.vertexAttributeDescriptionCount = (uint32_t)attributes.size();
-        vertexInput.pVertexAttributeDescriptions    = attributes.data();
-
-        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-        inputAssembly.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-
-        VkPipelineViewportStateCreateInfo viewportState{};
-        viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-        viewportState.viewportCount = 1; viewportState.scissorCount = 1;
-
-        VkPipelineRasterizationStateCreateInfo rasterizer{};
-        rasterizer.sType            = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-        rasterizer.polygonMode      = VK_POLYGON_MODE_FILL;
-        rasterizer.lineWidth        = 1.0f;
-        rasterizer.cullMode         = VK_CULL_MODE_BACK_BIT;
-        rasterizer.frontFace        = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-        rasterizer.depthBiasEnable  = VK_TRUE;
-
-        VkPipelineMultisampleStateCreateInfo multisampling{};
-        multisampling.sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-        multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-        VkPipelineDepthStencilStateCreateInfo depthStencil{};
-        depthStencil.sType            = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-        depthStencil.depthTestEnable  = VK_TRUE;
-        depthStencil.depthWriteEnable = VK_TRUE;
-        depthStencil.depthCompareOp   = VK_COMPARE_OP_LESS_OR_EQUAL;
-
-        VkPipelineColorBlendStateCreateInfo colorBlending{};
-        colorBlending.sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-        colorBlending.attachmentCount = 0;
-
-        std::vector<VkDynamicState> dynStates = {
-            VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR, VK_DYNAMIC_STATE_DEPTH_BIAS };
-        VkPipelineDynamicStateCreateInfo dynamicState{};
-        dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-        dynamicState.dynamicStateCount = (uint32_t)dynStates.size();
-        dynamicState.pDynamicStates    = dynStates.data();
-
-        VkDescriptorSetLayout setLayouts[2] = { descriptorSetLayout, boneDescriptorSetLayout };
-        VkPushConstantRange push{};
-        push.offset = 0; push.size = sizeof(ModelBufferObject);
-        push.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-        VkPipelineLayoutCreateInfo layoutInfo{};
-        layoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        layoutInfo.setLayoutCount         = 2;
-        layoutInfo.pSetLayouts            = setLayouts;
-        layoutInfo.pushConstantRangeCount = 1;
-        layoutInfo.pPushConstantRanges    = &push;
-
-        if (vkCreatePipelineLayout(VK::device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
-            throw std::runtime_error("Failed to create shadow skinned pipeline layout!");
-
-        VkGraphicsPipelineCreateInfo pipelineInfo{};
-        pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount          = 1;
-        pipelineInfo.pStages             = &stage;
-        pipelineInfo.pVertexInputState   = &vertexInput;
-        pipelineInfo.pInputAssemblyState = &inputAssembly;
-        pipelineInfo.pViewportState      = &viewportState;
-        pipelineInfo.pRasterizationState = &rasterizer;
-        pipelineInfo.pMultisampleState   = &multisampling;
-        pipelineInfo.pDepthStencilState  = &depthStencil;
-        pipelineInfo.pColorBlendState    = &colorBlending;
-        pipelineInfo.pDynamicState       = &dynamicState;
-        pipelineInfo.layout              = layout;
-        pipelineInfo.renderPass          = shadowRenderPass;
-        pipelineInfo.subpass             = 0;
-
-        VkPipeline result;
-        if (vkCreateGraphicsPipelines(VK::device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &result) != VK_SUCCESS)
-            throw std::runtime_error("Failed to create shadow skinned pipeline!");
-
-        vkDestroyShaderModule(VK::device, vertMod, nullptr);
         return result;
     }
 
@@ -1761,6 +1579,15 @@ public:
             updateDescriptorSets(currentFrame);
         }
 
+        // Skin every instance whose pose changed; both passes below read the result
+        if (currentScene != nullptr && currentScene->isReady && !currentScene->skinnedMeshes.empty()) {
+            SkinningPass::begin(commandBuffer, currentFrame);
+            for (SkinnedMesh3D* sm : currentScene->skinnedMeshes) {
+                if (sm->isVisible()) sm->dispatchSkinning(commandBuffer, currentFrame);
+            }
+            SkinningPass::barrier(commandBuffer, currentFrame);
+        }
+
         // Shadow Pass
         VkRenderPassBeginInfo shadowRenderPassInfo{};
         shadowRenderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -1798,16 +1625,13 @@ public:
                 for (Mesh3D *mesh : currentScene->meshes) {
                     mesh->draw(commandBuffer, shadowPipelineLayout, 1);
                 }
-                // Shadow pass for skinned meshes
-                if (!currentScene->skinnedMeshes.empty()) {
-                    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadowSkinnedPipeline);
-                    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                        shadowSkinnedPipelineLayout, 0, 1, &descriptorSets[currentFrame], 0, nullptr);
-                    for (SkinnedMesh3D* sm : currentScene->skinnedMeshes) {
-                        if (!sm->isVisible()) continue;
-                        sm->uploadBoneMatrices(currentFrame);
-                        sm->draw(commandBuffer, shadowSkinnedPipelineLayout, currentFrame);
-                    }
+                // skinned meshes are already skinned, the static shadow pipeline draws them
+                for (SkinnedMesh3D* sm : currentScene->skinnedMeshes) {
+                    if (!sm->isVisible()) continue;
+                    sm->draw(commandBuffer, shadowPipelineLayout, currentFrame);
+                }
+                for (CrowdMesh3D* crowd : currentScene->crowds) {
+                    crowd->draw(commandBuffer, shadowPipelineLayout, nullptr);
                 }
             }
         vkCmdEndRenderPass(commandBuffer);
@@ -1853,8 +1677,9 @@ public:
             vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, skyboxPipeline);
             skybox.draw(commandBuffer, pipelineLayout, 1);
 
-            // begin main draw
-            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline3D);
+            // begin main draw, meshes bind their own pipeline variant from here on
+            ShaderVariants::begin(commandBuffer);
+            ShaderVariants::bind(0);
 
 #ifdef DRAW_DEBUG
             prepareDebugMesh();
@@ -1863,16 +1688,30 @@ public:
             if (currentScene != nullptr && currentScene->isReady) {
                 currentScene->draw(commandBuffer, pipelineLayout, &window);
 
-                // Draw skinned meshes with the skinned pipeline
+                // Draw skinned meshes grouped by variant to keep pipeline switches down
                 if (!currentScene->skinnedMeshes.empty()) {
-                    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, skinnedPipeline);
-                    // set=0 is already bound from above; just draw each skinned mesh
+                    skinnedDrawList.clear();
                     for (SkinnedMesh3D* sm : currentScene->skinnedMeshes) {
-                        if (!sm->isVisible()) continue;
-                        sm->draw(commandBuffer, skinnedPipelineLayout, currentFrame);
+                        if (sm->isVisible() && sm->onScreen) skinnedDrawList.push_back(sm);
+                    }
+                    std::stable_sort(skinnedDrawList.begin(), skinnedDrawList.end(), [](const SkinnedMesh3D* a, const SkinnedMesh3D* b) {
+                        return ShaderVariants::variantFor(a->materialFeatures) < ShaderVariants::variantFor(b->materialFeatures);
+                    });
+                    // set=0 is already bound from above; just draw each skinned mesh
+                    for (SkinnedMesh3D* sm : skinnedDrawList) {
+                        sm->draw(commandBuffer, pipelineLayout, currentFrame);
+                    }
+                }
+
+                // baked crowds go through the same static pipelines
+                if (!currentScene->crowds.empty()) {
+                    Frustum frustum = currentScene->camera.getFrustum();
+                    for (CrowdMesh3D* crowd : currentScene->crowds) {
+                        crowd->draw(commandBuffer, pipelineLayout, &frustum);
                     }
                 }
             }
+            ShaderVariants::end();
 
             // render ui mesh
             vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, uiPipeline);
@@ -1980,9 +1819,27 @@ public:
         float animDt = (float)(animNow - lastAnimTime);
         lastAnimTime = animNow;
         if (currentScene && currentScene->isReady) {
+            // Every instance keeps its clock running; only those on screen and
+            // due at their LOD's rate are re-posed
+            glm::vec3 cameraPos = currentScene->camera.getPosition() * glm::vec3(WORLD_SCALE);
+            float projScale = std::abs(Engine::projectionMatrix[1][1]);
+            Frustum frustum = currentScene->camera.getFrustum();
+            animFrame++;
+
+            // baked crowds only need their clock
+            for (CrowdMesh3D* crowd : currentScene->crowds) crowd->advance(animDt);
+
+            animatedMeshes.clear();
             for (SkinnedMesh3D* sm : currentScene->skinnedMeshes) {
-                if (sm->isVisible()) sm->updateAnimation(animDt);
+                sm->advanceAnimation(animDt);
+                if (sm->selectAnimLOD(cameraPos, projScale, frustum, animFrame, currentFrame))
+                    animatedMeshes.push_back(sm);
             }
+            // Instances share only read-only skeleton/clip data, and the fence
+            // wait above means this frame's bone buffers are free to overwrite
+            Jobs::parallelFor(animatedMeshes.size(), [&](size_t i) {
+                animatedMeshes[i]->evaluateAnimation(currentFrame);
+            });
         }
 
         vkResetCommandBuffer(commandBuffers[currentFrame], /*VkCommandBufferResetFlagBits*/ 0);
@@ -2048,20 +1905,6 @@ public:
         //wayWin.update();
     }
 
-    VkShaderModule createShaderModule(const std::vector<char>& code) {
-        VkShaderModuleCreateInfo createInfo{};
-        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-        VkShaderModule shaderModule;
-        if (vkCreateShaderModule(VK::device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create shader module!");
-        }
-
-        return shaderModule;
-    }
-
     VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
         for (const auto& availableFormat : availableFormats) {
             if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
@@ -2254,16 +2097,20 @@ public:
     double lastAnimTime = 0.0;
     bool canJump = true;
 
-    void handle_input() {
+    // Hands the time since the last frame to the physics thread and syncs
+    // meshes from its last finished step
+    void update_physics() {
         currentScene->physManager->process(deltaTime);
+    }
 
+    void handle_input() {
         // handle mouse input
         glm::vec2 mouseVec = window.getMouseVector();
         currentScene->camera.pitch(-mouseVec.y * 0.001);
         currentScene->camera.yaw(mouseVec.x * 0.001);
 
         // handle user input
-        glm::vec3 camPos = physicsToWorld(currentScene->camera.rigidBody->getInterpolationWorldTransform().getOrigin()) + glm::vec3(0.0, 0.5, 0.0);
+        glm::vec3 camPos = currentScene->camera.getPosition() + glm::vec3(0.0, 0.25, 0.0);
 
         const glm::vec3 forward = currentScene->camera.getForward();
 
@@ -2293,16 +2140,18 @@ public:
             vel = glm::normalize(vel) * speed;
         }
         
-        currentScene->camera.rigidBody->setLinearVelocity(btVector3(vel.x, currentScene->camera.getVelY(), vel.z));
+        // the controller takes it from the next physics step and adds its
+        // own gravity
+        std::shared_ptr<Physics::CharacterController> controller = currentScene->camera.controller;
+        controller->setWalkVelocity(btVector3(vel.x, 0.0f, vel.z));
 
         // 1ft
         float jump_height = 3.048f;
 
-        // ground test
-        currentScene->camera.isGrounded(currentScene->physManager->dynamicsWorld);
+        // camera.grounded is the controller's ground state after the last physics step
         if (window.isKeyPressed(GLFW_KEY_SPACE)) { // jump
             if (currentScene->camera.grounded && canJump) {
-                currentScene->camera.rigidBody->setLinearVelocity(btVector3(currentScene->camera.getVelX(), jump_height,  currentScene->camera.getVelZ()));
+                controller->jump(jump_height);
             }
             canJump = false;
         } else {
@@ -2310,7 +2159,7 @@ public:
         }
 
         if (window.isKeyPressed(GLFW_KEY_J)) { // jump
-            currentScene->camera.rigidBody->setLinearVelocity(btVector3(currentScene->camera.getVelX(), jump_height,  currentScene->camera.getVelZ()));
+            controller->jump(jump_height);
             canJump = false;
         }
         
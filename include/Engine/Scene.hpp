@@ -3,6 +3,8 @@
 #include <stdio.h>
 #include <vector>
 #include <atomic>
+#include <string>
+#include <unordered_map>
 
 #include "Mesh3D.hpp"
 #include "imgui.h"
@@ -13,6 +15,8 @@
 #include "Engine/PhysicsManager.hpp"
 #include "Engine/Camera.hpp"
 #include "Engine/SkinnedMesh3D.hpp"
+#include "Engine/CrowdMesh3D.hpp"
+#include "VK/ShaderVariants.hpp"
 
 // forward declaration
 class Renderer;
@@ -23,6 +27,11 @@ public:
     //std::vector<Texture> textures;
     std::vector<Mesh3D*> meshes;
     std::vector<SkinnedMesh3D*> skinnedMeshes;
+    std::vector<CrowdMesh3D*> crowds;
+    // Removed skinned meshes by model, handed out again by create_skinned_object
+    std::unordered_map<std::string, std::vector<SkinnedMesh3D*>> skinnedPool;
+    // visible meshes for the current frame, reused to avoid reallocating
+    std::vector<Mesh3D*> drawList;
     Physics::PhysicsManager *physManager = nullptr;
     Camera camera;
 
@@ -57,7 +66,7 @@ public:
 
         physManager = new Physics::PhysicsManager(meshes, &camera);
 
-        // Register any skinned meshes that had createCapsuleRigidBody called during setup(),
+        // Register any skinned meshes that got a capsule body or character controller during setup(),
         // before physManager existed.
         for (SkinnedMesh3D* sm : skinnedMeshes) {
             if (sm->hasPhysics)
@@ -82,6 +91,7 @@ public:
         // world before they (and their parent meshes) are freed.
         delete physManager;
         physManager = nullptr;
+        camera.destroyRigidBody();
 
         uiMesh.destroy();
         for (Mesh3D *mesh : meshes) {
@@ -94,6 +104,18 @@ public:
             delete mesh;
         }
         skinnedMeshes.clear();
+        for (auto &[model, pooled] : skinnedPool) {
+            for (SkinnedMesh3D *mesh : pooled) {
+                mesh->destroy();
+                delete mesh;
+            }
+        }
+        skinnedPool.clear();
+        for (CrowdMesh3D *crowd : crowds) {
+            crowd->destroy();
+            delete crowd;
+        }
+        crowds.clear();
     }
 
     void add_object(Mesh3D *mesh) {
@@ -103,30 +125,50 @@ public:
     void remove_object(Mesh3D* mesh) {
         auto it = std::find(meshes.begin(), meshes.end(), mesh);
         if (it != meshes.end()) {
+            if (mesh->hasPhysics && physManager)
+                physManager->removeRigidBody(mesh);
             (*it)->destroy();
             delete *it;
             meshes.erase(it);
         }
     }
 
+    // The instance is kept (geometry, skinning ranges) for the next
+    // create_skinned_object of the same model; its body goes to physManager
     void remove_skinned_object(SkinnedMesh3D* mesh) {
+        if (!mesh) return;
         if (mesh->hasPhysics && physManager)
             physManager->removeSkinnedRigidBody(mesh);
         auto it = std::find(skinnedMeshes.begin(), skinnedMeshes.end(), mesh);
         if (it != skinnedMeshes.end()) {
+            mesh->setVisible(false);
+            skinnedPool[mesh->fileName].push_back(mesh);
+            skinnedMeshes.erase(it);
+        }
+    }
+
+    void remove_crowd(CrowdMesh3D* crowd) {
+        auto it = std::find(crowds.begin(), crowds.end(), crowd);
+        if (it != crowds.end()) {
             (*it)->destroy();
             delete *it;
-            skinnedMeshes.erase(it);
+            crowds.erase(it);
         }
     }
 
     // Register a skinned mesh's capsule rigid body with the physics simulation.
     // Must be called after create_skinned_object + createCapsuleRigidBody.
     void registerPhysics(SkinnedMesh3D* sm) {
-        if (!physManager || !sm->hasPhysics) return;
+        if (!physManager || !sm || !sm->hasPhysics) return;
         physManager->addSkinnedRigidBody(sm);
     }
 
+    // Runs a batch of rays/sweeps/overlaps after the next physics step
+    void submit_queries(std::shared_ptr<Physics::QueryBatch> batch) {
+        if (!physManager) return;
+        physManager->submitQueries(std::move(batch));
+    }
+
     Mesh3D* create_object(const char* modelPath) {
         Mesh3D* mesh = new Mesh3D();
         mesh->init(modelPath);
@@ -135,17 +177,37 @@ public:
     }
 
     SkinnedMesh3D* create_skinned_object(const char* modelPath) {
-        SkinnedMesh3D* mesh = new SkinnedMesh3D();
-        mesh->init(modelPath);
+        SkinnedMesh3D* mesh;
+        auto pooled = skinnedPool.find(modelPath);
+        if (pooled != skinnedPool.end() && !pooled->second.empty()) {
+            mesh = pooled->second.back();
+            pooled->second.pop_back();
+            mesh->reset();
+        } else {
+            mesh = new SkinnedMesh3D();
+            if (!mesh->init(modelPath)) {
+                // skinning pools are full: the spawn fails (nil in Lua), the game goes on
+                delete mesh;
+                return nullptr;
+            }
+        }
         skinnedMeshes.push_back(mesh);
         return mesh;
     }
 
+    // Bakes clip of modelPath on first use; add members to the returned crowd
+    CrowdMesh3D* create_crowd(const char* modelPath, int clip) {
+        CrowdMesh3D* crowd = new CrowdMesh3D();
+        crowd->init(modelPath, clip);
+        crowds.push_back(crowd);
+        return crowd;
+    }
+
     void load_lua_scene(const char* scriptPath);
 
     void handleUIInteraction() {
         const glm::vec3 forward = camera.getForward();
-        glm::vec3 camPos = physicsToWorld(camera.rigidBody->getInterpolationWorldTransform().getOrigin()) + glm::vec3(0.0, 0.25, 0.0);
+        glm::vec3 camPos = camera.getPosition();
 
         glm::vec2 result;
         glm::vec3 worldResult;
@@ -164,28 +226,28 @@ public:
     
     virtual void draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, Window *window) {
        
-        int c = 0;
+        drawList.clear();
         for (Mesh3D *mesh : meshes) {
             if (!mesh->isVisible()) continue;
             if (!mesh->hasPhysics) { // non physics-meshes dont have AABB, skip frustum culling
-                mesh->draw(commandBuffer, pipelineLayout, 1);
+                drawList.push_back(mesh);
                 continue;
             }
 
-            btVector3 AA;
-            btVector3 BB;
-            mesh->rigidBody->getAabb(AA, BB);
-            glm::vec3 min = glm::vec3(AA.getX(), AA.getY(), AA.getZ()) / glm::vec3(100.0);
-            glm::vec3 max = glm::vec3(BB.getX(), BB.getY(), BB.getZ()) / glm::vec3(100.0);
-
-            
-            if (mesh->isVisible() && camera.getFrustum().IsBoxVisible(min, max)) {
-                mesh->draw(commandBuffer, pipelineLayout, 1);
-                c++;
+            if (camera.isVisible(mesh->rigidBody)) {
+                drawList.push_back(mesh);
             }
 
         }
-        //printf("Displaying: %i/%i\n", c, meshes.size());
+
+        // group by pipeline variant so each one is bound once
+        std::stable_sort(drawList.begin(), drawList.end(), [](const Mesh3D *a, const Mesh3D *b) {
+            return ShaderVariants::variantFor(a->materialFeatures) < ShaderVariants::variantFor(b->materialFeatures);
+        });
+        for (Mesh3D *mesh : drawList) {
+            mesh->draw(commandBuffer, pipelineLayout, 1);
+        }
+        //printf("Displaying: %i/%i\n", drawList.size(), meshes.size());
     }
 
     virtual void drawUI(Window *window) {
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "btBulletDynamicsCommon.h"
+#include "BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h"
+#include "BulletCollision/CollisionShapes/btUniformScalingShape.h"
+
+#include "config.h"
+#include "Engine/Engine.hpp"
+#include "Engine/Mesh3D.hpp"
+#include "Engine/ConvexDecomposition.hpp"
+
+// Collision shapes shared by every instance of a model. The unscaled shape
+// is built once per (model, collider type); instances get a wrapper for
+// their scale (btScaledBvhTriangleMeshShape / btUniformScalingShape), also
+// shared between instances of the same scale.
+//
+// Built convex hulls (ConvexDecomposition.hpp) and trimesh BVHs are written
+// to SHAPE_CACHE_DIR and loaded from there on later runs, keyed by model and
+// collider type and checked against a hash of the geometry, so an edited
+// model rebuilds.
+// Shapes live for the whole run, like the rigid bodies using them.
+namespace ShapeCache {
+    struct Entry {
+        btCollisionShape *shape = nullptr;
+
+        // trimesh data the BVH shape reads from
+        std::vector<btScalar> positions;
+        std::vector<int> indices;
+        std::unique_ptr<btTriangleIndexVertexArray> meshInterface;
+        void *bvhBuffer = nullptr; // btAlignedAlloc'd, holds a BVH loaded from disk
+    };
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t colliderType;
+        uint64_t geometryHash;
+        uint64_t dataSize;
+        uint64_t checksum;
+    };
+
+    inline constexpr uint32_t FILE_MAGIC = 0x56534332; // "VSC2"
+
+    inline std::unordered_map<std::string, std::unique_ptr<Entry>> entries;
+    inline std::unordered_map<std::string, btCollisionShape *> scaledShapes;
+
+    inline std::string cachePath(const std::string &key) {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)Utils::hashBytes(key.data(), key.size()));
+        return std::string(SHAPE_CACHE_DIR) + "/" + name;
+    }
+
+    inline bool readCacheFile(const std::string &key, uint32_t colliderType, uint64_t geometryHash, std::vector<char> &data) {
+        std::ifstream file(cachePath(key), std::ios::binary | std::ios::ate);
+        if (!file.is_open() || (size_t) file.tellg() < sizeof(FileHeader)) return false;
+        size_t fileSize = (size_t) file.tellg();
+        file.seekg(0);
+
+        FileHeader header;
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (header.magic != FILE_MAGIC || header.colliderType != colliderType ||
+            header.geometryHash != geometryHash || header.dataSize != fileSize - sizeof(FileHeader)) {
+            return false;
+        }
+
+        data.resize(header.dataSize);
+        file.read(data.data(), data.size());
+        return file && Utils::hashBytes(data.data(), data.size()) == header.checksum;
+    }
+
+    inline void writeCacheFile(const std::string &key, uint32_t colliderType, uint64_t geometryHash, const void *data, size_t size) {
+        FileHeader header{};
+        header.magic = FILE_MAGIC;
+        header.colliderType = colliderType;
+        header.geometryHash = geometryHash;
+        header.dataSize = size;
+        header.checksum = Utils::hashBytes(data, size);
+
+        std::error_code error;
+        std::filesystem::create_directories(SHAPE_CACHE_DIR, error);
+
+        // same temp-file dance as the pipeline cache
+        std::string path = cachePath(key);
+        std::string tmpPath = path + ".tmp";
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                Logger::warning("ShapeCache", "Failed to write cache file");
+                return;
+            }
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(static_cast<const char *>(data), size);
+        }
+        std::remove(path.c_str());
+        std::rename(tmpPath.c_str(), path.c_str());
+    }
+
+    inline uint64_t geometryHash(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices) {
+        uint64_t hash = Utils::hashBytes(indices.data(), indices.size() * sizeof(uint32_t));
+        for (const Vertex &vertex : vertices) {
+            hash ^= Utils::hashBytes(&vertex.pos, sizeof(vertex.pos));
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Cache format for hull colliders: per hull a point count, then its points
+    inline std::vector<char> packHulls(const std::vector<Convex::Hull> &hulls) {
+        std::vector<char> data;
+        auto append = [&data](const void *bytes, size_t size) {
+            data.insert(data.end(), static_cast<const char *>(bytes), static_cast<const char *>(bytes) + size);
+        };
+        for (const Convex::Hull &hull : hulls) {
+            uint32_t count = (uint32_t)hull.points.size();
+            append(&count, sizeof(count));
+            for (const btVector3 &point : hull.points) {
+                btVector3FloatData packed;
+                point.serializeFloat(packed);
+                append(&packed, sizeof(packed));
+            }
+        }
+        return data;
+    }
+
+    inline bool unpackHulls(const std::vector<char> &data, std::vector<Convex::Hull> &hulls) {
+        size_t offset = 0;
+        while (offset < data.size()) {
+            uint32_t count;
+            if (data.size() - offset < sizeof(count)) return false;
+            memcpy(&count, data.data() + offset, sizeof(count));
+            offset += sizeof(count);
+            if ((data.size() - offset) / sizeof(btVector3FloatData) < count) return false;
+
+            Convex::Hull hull;
+            hull.points.resize(count);
+            for (uint32_t i = 0; i < count; i++) {
+                btVector3FloatData packed;
+                memcpy(&packed, data.data() + offset, sizeof(packed));
+                offset += sizeof(packed);
+                hull.points[i].deSerializeFloat(packed);
+            }
+            hulls.push_back(std::move(hull));
+        }
+        return !hulls.empty();
+    }
+
+    inline btConvexHullShape *hullShape(const std::vector<btVector3> &points) {
+        btConvexHullShape *hull = new btConvexHullShape(&points[0].getX(), (int)points.size());
+        hull->setMargin(0.001);
+        return hull;
+    }
+
+    // One bounded hull around every vertex (CONVEXHULL), or a compound of
+    // hulls from a convex decomposition (DECOMPOSED)
+    inline btCollisionShape *buildHulls(const std::string &key, ColliderType type, const std::vector<Vertex> &vertices,
+                                        const std::vector<uint32_t> &indices, uint64_t hash) {
+        std::vector<Convex::Hull> hulls;
+        std::vector<char> data;
+        if (!readCacheFile(key, type, hash, data) || !unpackHulls(data, hulls)) {
+            hulls.clear();
+            if (type == ColliderType::DECOMPOSED) {
+                hulls = Convex::decompose(vertices, indices);
+            } else {
+                hulls.push_back(Convex::buildHull(vertices));
+            }
+            if (hulls.empty() || hulls[0].points.empty()) throw std::runtime_error("no collision hull for " + key);
+
+            data = packHulls(hulls);
+            writeCacheFile(key, type, hash, data.data(), data.size());
+            Logger::info("ShapeCache", (key + ": " + std::to_string(hulls.size()) + " hull(s) baked").c_str());
+        }
+
+        if (type == ColliderType::CONVEXHULL) return hullShape(hulls[0].points);
+
+        btCompoundShape *compound = new btCompoundShape();
+        btTransform identity;
+        identity.setIdentity();
+        for (const Convex::Hull &hull : hulls) {
+            if (hull.points.empty()) continue;
+            compound->addChildShape(identity, hullShape(hull.points));
+        }
+        return compound;
+    }
+
+    inline btCollisionShape *buildTrimesh(Entry &entry, const std::string &key, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, uint64_t hash) {
+        entry.positions.resize(vertices.size() * 3);
+        for (size_t i = 0; i < vertices.size(); i++) {
+            entry.positions[i * 3 + 0] = vertices[i].pos.x;
+            entry.positions[i * 3 + 1] = vertices[i].pos.y;
+            entry.positions[i * 3 + 2] = vertices[i].pos.z;
+        }
+        entry.indices.assign(indices.begin(), indices.end());
+        entry.meshInterface = std::make_unique<btTriangleIndexVertexArray>(
+            (int)(entry.indices.size() / 3), entry.indices.data(), (int)(3 * sizeof(int)),
+            (int)vertices.size(), entry.positions.data(), (int)(3 * sizeof(btScalar))
+        );
+
+        btBvhTriangleMeshShape *shape = nullptr;
+
+        std::vector<char> data;
+        if (readCacheFile(key, TRIMESH, hash, data)) {
+            // the BVH is used in place, so it keeps its (aligned) buffer
+            entry.bvhBuffer = btAlignedAlloc(data.size(), 16);
+            memcpy(entry.bvhBuffer, data.data(), data.size());
+            btOptimizedBvh *bvh = btOptimizedBvh::deSerializeInPlace(entry.bvhBuffer, (unsigned)data.size(), false);
+            if (bvh) {
+                shape = new btBvhTriangleMeshShape(entry.meshInterface.get(), true, false);
+                shape->setOptimizedBvh(bvh);
+            } else {
+                btAlignedFree(entry.bvhBuffer);
+                entry.bvhBuffer = nullptr;
+            }
+        }
+
+        if (!shape) {
+            shape = new btBvhTriangleMeshShape(entry.meshInterface.get(), true, true);
+
+            btOptimizedBvh *bvh = shape->getOptimizedBvh();
+            unsigned size = bvh->calculateSerializeBufferSize();
+            void *buffer = btAlignedAlloc(size, 16);
+            if (bvh->serializeInPlace(buffer, size, false)) {
+                writeCacheFile(key, TRIMESH, hash, buffer, size);
+            }
+            btAlignedFree(buffer);
+        }
+
+        shape->setMargin(0.001);
+        return shape;
+    }
+
+    // Shape for one instance of a model with the given scale
+    inline btCollisionShape *get(const std::string &model, ColliderType type, const std::vector<Vertex> &vertices,
+                                 const std::vector<uint32_t> &indices, glm::vec3 size, glm::vec3 scale) {
+        char scaleKey[96];
+        snprintf(scaleKey, sizeof(scaleKey), "#%d#%g,%g,%g", (int)type, scale.x, scale.y, scale.z);
+        std::string instanceKey = model + scaleKey;
+
+        auto scaledIt = scaledShapes.find(instanceKey);
+        if (scaledIt != scaledShapes.end()) return scaledIt->second;
+
+        btCollisionShape *shape = nullptr;
+        btVector3 localScaling(scale.x, scale.y, scale.z);
+
+        if (type == ColliderType::BOX) {
+            // just a box, nothing worth sharing unscaled
+            btCompoundShape *compound = new btCompoundShape();
+            btBoxShape *child = new btBoxShape(btVector3(size.x / 2.0, size.y / 2.0, size.z / 2.0));
+            btTransform localTransform;
+            localTransform.setIdentity();
+            compound->addChildShape(localTransform, child);
+            compound->setLocalScaling(localScaling);
+            compound->setMargin(0.001);
+            shape = compound;
+        } else {
+            std::string key = model + "#" + std::to_string((int)type);
+            std::unique_ptr<Entry> &entry = entries[key];
+            if (!entry) {
+                entry = std::make_unique<Entry>();
+                uint64_t hash = geometryHash(vertices, indices);
+                entry->shape = type == ColliderType::TRIMESH
+                    ? buildTrimesh(*entry, key, vertices, indices, hash)
+                    : buildHulls(key, type, vertices, indices, hash);
+            }
+
+            bool unitScale = scale == glm::vec3(1.0f);
+            bool uniformScale = scale.x == scale.y && scale.y == scale.z;
+            if (unitScale) {
+                shape = entry->shape;
+            } else if (type == ColliderType::TRIMESH) {
+                shape = new btScaledBvhTriangleMeshShape(static_cast<btBvhTriangleMeshShape *>(entry->shape), localScaling);
+            } else if (type == ColliderType::DECOMPOSED) {
+                // compound scaling rescales its children, so give it its own
+                btCompoundShape *source = static_cast<btCompoundShape *>(entry->shape);
+                btCompoundShape *compound = new btCompoundShape();
+                for (int i = 0; i < source->getNumChildShapes(); i++) {
+                    btConvexHullShape *child = static_cast<btConvexHullShape *>(source->getChildShape(i));
+                    const btVector3 *points = child->getUnscaledPoints();
+                    compound->addChildShape(source->getChildTransform(i),
+                        hullShape(std::vector<btVector3>(points, points + child->getNumPoints())));
+                }
+                compound->setLocalScaling(localScaling);
+                compound->setMargin(0.001);
+                shape = compound;
+            } else if (uniformScale) {
+                shape = new btUniformScalingShape(static_cast<btConvexShape *>(entry->shape), scale.x);
+            } else {
+                // non-uniform hulls can't wrap the shared one, copy its points
+                btConvexHullShape *source = static_cast<btConvexHullShape *>(entry->shape);
+                const btVector3 *points = source->getUnscaledPoints();
+                btConvexHullShape *hull = hullShape(std::vector<btVector3>(points, points + source->getNumPoints()));
+                hull->setLocalScaling(localScaling);
+                shape = hull;
+            }
+        }
+
+        scaledShapes[instanceKey] = shape;
+        return shape;
+    }
+
+    // Capsule (Y up) shared by every body of the same size
+    inline btCollisionShape *capsule(float radius, float height, float margin) {
+        char key[96];
+        snprintf(key, sizeof(key), "#capsule#%g,%g,%g", radius, height, margin);
+
+        btCollisionShape *&shape = scaledShapes[key];
+        if (!shape) {
+            shape = new btCapsuleShape(radius, height);
+            shape->setMargin(margin);
+        }
+        return shape;
+    }
+}
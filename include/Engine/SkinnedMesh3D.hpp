@@ -8,12 +8,21 @@
 #include <string>
 #include <array>
 #include <algorithm>
+#include <memory>
 #include <unordered_map>
 
 #include "config.h"
 #include "Engine/Mesh3D.hpp"
+#include "Engine/PoseMath.hpp"
+#include "Engine/FrustumCull.hpp"
+#include "VK/SkinningPass.hpp"
+
+namespace Physics { class CharacterController; }
 
 #define MAX_BONES 256
+#define MAX_ANIM_LAYERS 4
+// animation LOD from which joints with little skin influence are dropped
+#define ANIM_LOD_REDUCED_JOINTS 2
 
 // Animation sampler: times + interpolated output values
 struct AnimSampler {
@@ -30,6 +39,7 @@ struct AnimChannel {
     int samplerIndex;
 };
 
+// Animation as read from glTF, only used while loading (see AnimClip)
 struct SkinAnimation {
     std::string name;
     std::vector<AnimSampler> samplers;
@@ -37,30 +47,105 @@ struct SkinAnimation {
     float duration = 0.0f;
 };
 
+enum class AnimPath : uint8_t { Translation, Rotation, Scale };
+enum class AnimInterpolation : uint8_t { Step, Linear, CubicSpline };
+
+// One joint property driven by one sampler. Keys live in AnimClip::times
+// [firstKey, firstKey + keyCount); values in AnimClip::values starting at
+// firstValue, three per key ([in-tangent, value, out-tangent]) for CubicSpline.
+struct AnimTrack {
+    uint16_t joint;
+    AnimPath path;
+    AnimInterpolation interpolation;
+    uint32_t firstKey;
+    uint32_t keyCount;
+    uint32_t firstValue;
+    float invInterval = 0.0f; // 1 / key spacing when keys are evenly spaced, else 0
+};
+
+// Runtime form of a SkinAnimation: validated, string-free, tracks sorted by
+// joint and all key data packed into two flat arrays.
+struct AnimClip {
+    std::string name;
+    float duration = 0.0f;
+    std::vector<AnimTrack> tracks;
+    std::vector<float>     times;
+    std::vector<glm::vec4> values;
+};
+
 struct Joint {
     int nodeIndex;           // glTF node index
     int parentJoint = -1;    // -1 if root joint
     std::string name;
-    glm::mat4 inverseBindMatrix{1.0f};
-    // Current local transform — overwritten each frame by animation sampling
-    glm::vec3 localPos{0.0f};
-    glm::quat localRot{1.0f, 0.0f, 0.0f, 0.0f};
-    glm::vec3 localScale{1.0f};
+    Affine3x4 inverseBind = PoseMath::identity();
+    // Rest pose from the glTF node
+    glm::vec3 restPos{0.0f};
+    glm::quat restRot{1.0f, 0.0f, 0.0f, 0.0f};
+    glm::vec3 restScale{1.0f};
 };
 
-// Geometry and skeleton shared by all instances of the same model file.
+// One clip playing on a layer. clip is -1 when nothing plays.
+struct AnimPlayback {
+    int clip = -1;
+    float time = 0.0f;
+    // Last key interval per track, so sampling steps forward instead of searching
+    std::vector<uint32_t> cursors;
+};
+
+// Layer 0 is the base pose; higher layers are mixed over it (or added to it)
+// on the joints in their mask. Starting a clip with a fade crossfades from
+// the one that was playing.
+struct AnimLayer {
+    AnimPlayback current;
+    AnimPlayback previous;   // being faded out while fadeDuration > 0
+    float fadeElapsed = 0.0f;
+    float fadeDuration = 0.0f;
+    float weight = 1.0f;
+    bool looping = true;
+    bool additive = false;   // delta against the rest pose instead of a mix
+    std::vector<float> mask; // per-joint weight, empty for every joint
+    // What the layer last showed during a fade, and at what share of its
+    // weight. A fade started before the last one finished freezes that into
+    // snapshot and continues from it instead of dropping one of the clips.
+    PoseSoA shown, snapshot;
+    float shownWeight = 1.0f, snapshotWeight = 1.0f;
+    bool shownValid = false;    // captured during the fade in flight
+    bool fromSnapshot = false;  // the fade in flight starts at snapshot, not previous
+};
+
+// A clip pre-skinned at VAT_BAKE_RATE: frameCount consecutive copies of the
+// mesh as plain Vertex data, so the static pipelines draw frame f with
+// vertexOffset = f * vertex count. Used by CrowdMesh3D.
+struct BakedClip {
+    VkBuffer       buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    uint32_t frameCount = 0;
+    float    frameRate  = 0.0f;
+    float    duration   = 0.0f;
+};
+
+// Geometry, skeleton and clips shared by all instances of the same model file.
+// Immutable once loaded (apart from bakedClips, filled on the main thread);
+// instances only keep a pointer to it.
 struct SharedSkinnedGeometry {
+    std::string path;
     std::vector<SkinnedVertex> vertices;
     std::vector<uint32_t>      indices;
     glm::vec3 AA{0}, BB{0}, modelCenter{0};
-    VkBuffer       vertexBuffer       = VK_NULL_HANDLE;
-    VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
+    SkinningPass::Range sourceRange{0, 0}; // in SkinningPass::sourcePool
     VkBuffer       indexBuffer        = VK_NULL_HANDLE;
     VkDeviceMemory indexBufferMemory  = VK_NULL_HANDLE;
     std::vector<Joint>         joints;
-    std::vector<SkinAnimation> animations;
+    std::vector<AnimClip> animations;
+    PoseSoA restPose;
+    // Reduced joint set for far LODs: kept flag per joint (padded like the
+    // pose), and the joint whose matrix each one uses (itself when kept)
+    std::vector<uint8_t> lodJointKept;
+    std::vector<int>     lodJointTarget;
+    std::unordered_map<int, BakedClip> bakedClips; // by clip index
     bool hasSkin      = false;
     int  testBoneIndex = -1;
+    uint32_t materialFeatures = 0;
     int  refCount      = 0;
 };
 
@@ -70,40 +155,66 @@ public:
     static std::unordered_map<std::string, SharedSkinnedGeometry*> s_cache;
     SharedSkinnedGeometry* skinnedSharedGeom = nullptr;
 
-    // Typed vertex data (Mesh3D::m_vertices holds Vertex; this holds SkinnedVertex)
-    std::vector<SkinnedVertex> m_skinnedVertices;
-
-    // Per-frame persistently-mapped bone matrix SSBOs
-    VkBuffer boneBuffers[MAX_FRAMES_IN_FLIGHT]{};
-    VkDeviceMemory boneBufferMemories[MAX_FRAMES_IN_FLIGHT]{};
-    void* boneMappedPtrs[MAX_FRAMES_IN_FLIGHT]{};
+    // This instance's palette in SkinningPass::boneBuffers (one matrix per
+    // joint, same range every frame) and vertices in SkinningPass::outputBuffers
+    SkinningPass::Range boneRange{0, 0};
+    SkinningPass::Range outputRange{0, 0};
+    // frame buffers whose palette changed since they were last skinned
+    uint32_t unskinnedFrames = 0;
 
-    // Descriptor pool owned by this mesh (keeps it isolated from scene pool)
-    VkDescriptorPool boneDescriptorPool = VK_NULL_HANDLE;
-    VkDescriptorSet boneDescriptorSets[MAX_FRAMES_IN_FLIGHT]{};
+    // Per-instance state: local pose, hierarchy scratch and playback.
+    // Skeleton and clips are read through skinnedSharedGeom, which is never
+    // written after load, so instances can be updated on different threads.
+    PoseSoA pose;
+    std::vector<Affine3x4> worldTransforms;
 
-    std::vector<Joint> joints;
-    std::vector<glm::mat4> boneMatrices;
+    std::array<AnimLayer, MAX_ANIM_LAYERS> layers;
+    // Per-layer sampling targets, sized at init so blending never allocates
+    PoseSoA blendFrom, blendTo;
 
-    std::vector<SkinAnimation> animations;
-    int currentAnimation = 0;
-    float animTime = 0.0f;
-    bool looping = true;
-    bool hasSkin = false;
+    // Animation LOD, chosen by selectAnimLOD each frame. LOD n re-poses every
+    // 2^n frames; animPhase staggers instances so they don't all land together.
+    int animLOD = 0;
+    bool onScreen = false;   // false until the first LOD pass, which then poses it at once
+    uint32_t animPhase = 0;
+    uint32_t staleFrames = 0; // frame buffers that missed the last evaluation
+    int paletteFrame = 0;     // frame buffer the last evaluation wrote
 
-    int testBoneIndex = -1;
     float testBonePhase = 0.0f;
 
     SkinnedMesh3D() = default;
 
-    void init(const char* filename);
+    // False if the skinning pools are full; destroy() has then been called
+    bool init(const char* filename);
     void destroy();
+    // Back to the state init left it in, keeping geometry and pool ranges,
+    // so Scene can hand the instance out again for the same model
+    void reset();
 
-    // Call once per frame before drawing to advance animation
-    void updateAnimation(float dt);
-    // Upload current boneMatrices to GPU for the given frame index
-    void uploadBoneMatrices(int frameIndex);
-    // Bind bone descriptor set (set=1) and draw
+    // Shared geometry for filename from s_cache, loaded and uploaded on first
+    // use. Every acquire needs a matching releaseGeometry.
+    static SharedSkinnedGeometry* acquireGeometry(const char* filename);
+    static void releaseGeometry(SharedSkinnedGeometry* geom);
+    // Skinning palette for pose; world is scratch for pose.padded() entries
+    static void buildPalette(const SharedSkinnedGeometry& geom, const PoseSoA& pose,
+                             Affine3x4* world, Affine3x4* palette, bool reduced);
+    // Bakes clipIndex (clamped) on first use and keeps it with the geometry
+    static const BakedClip& bakeClip(SharedSkinnedGeometry& geom, int clipIndex);
+
+    // Advances clip times and fades only. Cheap enough to run every frame for
+    // every instance, so hidden or throttled ones resume in the right place.
+    void advanceAnimation(float dt);
+    // Samples and blends the layers and writes the skinning palette straight
+    // into this frame's palette range. Touches only this instance, so
+    // different instances may be evaluated concurrently.
+    void evaluateAnimation(int frameIndex);
+    // Picks animLOD from the projected size and updates onScreen. Returns
+    // whether the pose should be evaluated this frame.
+    bool selectAnimLOD(const glm::vec3& cameraPos, float projScale, Frustum& frustum, uint64_t frame, int frameIndex);
+    // Records skinning.comp for frameIndex if its palette changed since the
+    // last dispatch. Expects SkinningPass::begin to have been recorded.
+    void dispatchSkinning(VkCommandBuffer commandBuffer, int frameIndex);
+    // Draws the skinned vertices of frameIndex with any static Vertex pipeline
     void draw(VkCommandBuffer commandBuffer, VkPipelineLayout layout, int frameIndex);
 
     void updateModelMatrix();
@@ -114,27 +225,55 @@ public:
     // Capsule rigid body — alternative to Mesh3D::createRigidBody for character controllers
     void createCapsuleRigidBody(float mass, float radius = 0.3f, float height = 1.0f);
 
-    void playAnimation(int index) {
-        currentAnimation = std::clamp(index, 0, (int)animations.size() - 1);
-        animTime = 0.0f;
-    }
-    void setLooping(bool loop) { looping = loop; }
+    // Kinematic capsule walked with sweeps instead of forces (see
+    // CharacterController), used in place of createCapsuleRigidBody
+    std::shared_ptr<Physics::CharacterController> character;
+    void createCharacterController(float radius = 0.3f, float height = 1.0f,
+                                   float stepHeight = 0.35f, float maxSlopeDegrees = 50.0f);
+    // Horizontal, world units per second; the controller adds gravity
+    void setWalkVelocity(glm::vec3 velocity);
+    void jump(float speed);
+    void teleport(glm::vec3 target);
+    // As of the last physics step
+    bool isGrounded() const;
+
+    const std::vector<Joint>& joints() const { return skinnedSharedGeom->joints; }
+    const std::vector<AnimClip>& animations() const { return skinnedSharedGeom->animations; }
+    bool hasSkin() const { return skinnedSharedGeom && skinnedSharedGeom->hasSkin; }
+
+    // Hard cut on the base layer
+    void playAnimation(int index) { playLayer(0, std::max(index, 0), 0.0f); }
+    // Blend the base layer from its current clip into index over duration seconds
+    void crossFade(int index, float duration) { playLayer(0, std::max(index, 0), duration); }
+    void setLooping(bool loop) { setLayerLooping(0, loop); }
     void setAnimSpeed(float speed) { animSpeed = speed; }
+
+    // Layered playback. Invalid layer indices are ignored; a clip index of -1 stops the layer.
+    void playLayer(int layer, int index, float fadeDuration);
+    void stopLayer(int layer, float fadeDuration);
+    void setLayerWeight(int layer, float weight);
+    void setLayerAdditive(int layer, bool additive);
+    void setLayerLooping(int layer, bool loop);
+    // Restricts a layer to jointName and its descendants; false if there is no such joint
+    bool setLayerMask(int layer, const std::string& jointName);
+    void clearLayerMask(int layer);
+    int findJoint(const std::string& name) const;
     float getAnimSpeed() const { return animSpeed; }
 
-    int getJointCount()    const { return (int)joints.size(); }
-    int getTestBoneIndex() const { return testBoneIndex; }
-    int getAnimCount()     const { return (int)animations.size(); }
-    float getAnimTime()    const { return animTime; }
+    int getJointCount()    const { return skinnedSharedGeom ? (int)joints().size() : 0; }
+    int getTestBoneIndex() const { return skinnedSharedGeom ? skinnedSharedGeom->testBoneIndex : -1; }
+    int getAnimCount()     const { return skinnedSharedGeom ? (int)animations().size() : 0; }
+    float getAnimTime()    const { return layers[0].current.time; }
     float getAnimDuration(int index) const {
-        int i = std::clamp(index, 0, (int)animations.size() - 1);
-        return animations.empty() ? 0.0f : animations[i].duration;
+        if (getAnimCount() == 0) return 0.0f;
+        return animations()[std::clamp(index, 0, getAnimCount() - 1)].duration;
     }
 
 private:
-    void loadSkinnedModel(const char* filename);
-    void createVertexBuffer();
-    void createIndexBuffer();
-    void createBoneBuffers();
-    void computeJointMatrices();
+    static void loadSkinnedModel(const char* filename, SharedSkinnedGeometry& geom);
+    static void createIndexBuffer(SharedSkinnedGeometry& geom);
+    void computeJointMatrices(Affine3x4* palette, bool reduced);
+    void writeRestPalette();
+    static void computeLODJoints(SharedSkinnedGeometry& geom);
+    AnimLayer* layerAt(int layer) { return layer >= 0 && layer < MAX_ANIM_LAYERS ? &layers[layer] : nullptr; }
 };
@@ -9,6 +9,17 @@
 
 //#include <assimp/scene.h>
 
+class Texture;
+
+// One entry for Texture::loadBatch. `image` set means tinygltf already decoded
+// the pixels, otherwise `path` is read from the asset zip and decoded.
+struct TextureLoadRequest {
+    Texture *texture = nullptr;
+    std::string path;
+    const tinygltf::Image *image = nullptr;
+    VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+};
+
 class Texture {
 public:
     VkImage textureImage;
@@ -20,10 +31,17 @@ public:
     void createTextureImageView();
 
     void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
+    static void recordMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
+
+    // Decodes every request on the job pool straight into one shared staging
+    // buffer, then uploads and mipmaps all of them in a single submission
+    static void loadBatch(std::vector<TextureLoadRequest> &requests);
 
     void createTextureImage(const char *path);
     //void createAssimpTextureImage(aiTexture *tex);
     void createFromGLTFImage(const tinygltf::Image& image, VkFormat format);
+    // Upload already decoded RGBA8 pixels, mip chain capped at maxMipLevels
+    void createFromPixels(const unsigned char *pixels, int texWidth, int texHeight, VkFormat format, uint32_t maxMipLevels, const char *name);
     void destroy();
     std::string hashTexture(const char *data, size_t size);
 };
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <unordered_map>
+
+#include "tiny_gltf.h"
+
+// Textures up to this size (in both dimensions) are candidates for packing
+#define ATLAS_MAX_TILE 256
+// Atlas page width/height limit
+#define ATLAS_SIZE 2048
+// Edge-extended border around every tile so bilinear filtering and the first
+// few mips don't bleed neighbouring tiles into each other
+#define ATLAS_PADDING 4
+
+// Where a packed image ended up: sample atlas `textureID` at uv * scale + offset
+struct AtlasRegion {
+    int textureID = -1;
+    glm::vec2 offset{0.0f};
+    glm::vec2 scale{1.0f};
+
+    glm::vec2 remap(glm::vec2 uv) const { return uv * scale + offset; }
+};
+
+namespace TextureAtlas {
+    // Packs the small base colour images of a glTF model into one shared
+    // texture and returns region info keyed by glTF image index. Images that
+    // are large, tile their UVs outside [0,1], or are reused as normal/MR maps
+    // are left out and should be loaded as standalone textures as before.
+    std::unordered_map<int, AtlasRegion> packModel(const tinygltf::Model& model, const std::string& atlasName);
+};
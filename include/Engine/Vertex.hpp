@@ -144,7 +144,6 @@ struct SkinnedVertex {
 // wip
 struct ModelBufferObject {
     alignas(16) glm::mat4 model;
-    alignas(4) int enableNormal;
     alignas(4) float metallic;
     alignas(4) float roughness;
 };
\ No newline at end of file
@@ -68,7 +68,7 @@ class MainScene : public Scene {
         }
 
         const glm::vec3 forward = camera.getForward();
-        glm::vec3 camPos = physicsToWorld(camera.rigidBody->getInterpolationWorldTransform().getOrigin()) + glm::vec3(0.0, 0.25, 0.0);
+        glm::vec3 camPos = camera.getPosition();
         glm::vec3 rot = glm::degrees(glm::eulerAngles(camera.getOrientation()));
 
         // handle mouse interaction with UI
@@ -89,8 +89,7 @@ class MainScene : public Scene {
         if (camera.getPosition().y < -10.0) {
             btTransform tr;
             tr.setIdentity();
-            camera.rigidBody->setWorldTransform(tr);
-            camera.rigidBody->setLinearVelocity(btVector3(0,0,0));
+            camera.resetBody(tr);
         } 
 
         // draw all meshes in scene
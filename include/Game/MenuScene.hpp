@@ -11,7 +11,7 @@ class MenuScene : public Scene {
     float lastTime = deltaTime;
 
     void setup() override {
-        //anim.currentIndex = 0;
+        anim.currentIndex = 0;
         anim.time = 0.0;
 
         anim.keyframes.push_back({
@@ -98,8 +98,7 @@ class MenuScene : public Scene {
         btTransform tf;
         tf.setIdentity();
 
-        camera.rigidBody->setWorldTransform(tf);
-        camera.rigidBody->setLinearVelocity(btVector3(0,0,0));
+        camera.resetBody(tf);
 
         camera.setPosition({0.0,0.0,0.0});
         glm::quat rot = camera.getOrientation();
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <volk.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "Engine/Engine.hpp"
+
+// Persistent VkPipelineCache shared by every pipeline (and ImGui).
+// The file starts with a small header of our own so a blob from another
+// GPU or driver is thrown away instead of being fed to the driver.
+namespace PipelineCache {
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t  pipelineCacheUUID[VK_UUID_SIZE];
+        uint64_t dataSize;
+        uint64_t checksum;
+    };
+
+    inline constexpr uint32_t FILE_MAGIC = 0x56504331; // "VPC1"
+
+    inline FileHeader headerForDevice() {
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(VK::physicalDevice, &props);
+
+        FileHeader header{};
+        header.magic = FILE_MAGIC;
+        header.vendorID = props.vendorID;
+        header.deviceID = props.deviceID;
+        header.driverVersion = props.driverVersion;
+        memcpy(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+        return header;
+    }
+
+    // Reads the cache from disk if it matches this device/driver, else starts empty
+    inline void init(const char *path = PIPELINE_CACHE_PATH) {
+        FileHeader expected = headerForDevice();
+        std::vector<char> data;
+
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (file.is_open() && (size_t) file.tellg() >= sizeof(FileHeader)) {
+            size_t fileSize = (size_t) file.tellg();
+            file.seekg(0);
+
+            FileHeader header;
+            file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+            bool valid = header.magic == expected.magic &&
+                         header.vendorID == expected.vendorID &&
+                         header.deviceID == expected.deviceID &&
+                         header.driverVersion == expected.driverVersion &&
+                         memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) == 0 &&
+                         header.dataSize == fileSize - sizeof(FileHeader);
+
+            if (valid) {
+                data.resize(header.dataSize);
+                file.read(data.data(), data.size());
+                if (!file || Utils::hashBytes(data.data(), data.size()) != header.checksum) {
+                    data.clear();
+                }
+            }
+
+            if (data.empty()) {
+                Logger::warning("PipelineCache", "Cache file is stale or from another device, rebuilding");
+            }
+        }
+
+        VkPipelineCacheCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = data.size();
+        createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+        if (vkCreatePipelineCache(VK::device, &createInfo, nullptr, &VK::pipelineCache) != VK_SUCCESS) {
+            // drivers may still reject data that passed our checks, retry empty
+            createInfo.initialDataSize = 0;
+            createInfo.pInitialData = nullptr;
+            if (vkCreatePipelineCache(VK::device, &createInfo, nullptr, &VK::pipelineCache) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create pipeline cache!");
+            }
+        }
+
+        if (!data.empty()) {
+            Logger::info("PipelineCache", ("Loaded " + std::to_string(data.size()) + " bytes").c_str());
+        }
+    }
+
+    inline void save(const char *path = PIPELINE_CACHE_PATH) {
+        if (VK::pipelineCache == VK_NULL_HANDLE) return;
+
+        size_t size = 0;
+        if (vkGetPipelineCacheData(VK::device, VK::pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0) return;
+        std::vector<char> data(size);
+        if (vkGetPipelineCacheData(VK::device, VK::pipelineCache, &size, data.data()) != VK_SUCCESS) return;
+        data.resize(size);
+
+        FileHeader header = headerForDevice();
+        header.dataSize = data.size();
+        header.checksum = Utils::hashBytes(data.data(), data.size());
+
+        // write to a temp file first so a crash never leaves a half-written cache
+        std::string tmpPath = std::string(path) + ".tmp";
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                Logger::warning("PipelineCache", "Failed to write cache file");
+                return;
+            }
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(data.data(), data.size());
+        }
+        std::remove(path);
+        std::rename(tmpPath.c_str(), path);
+    }
+
+    inline void destroy() {
+        if (VK::pipelineCache == VK_NULL_HANDLE) return;
+        vkDestroyPipelineCache(VK::device, VK::pipelineCache, nullptr);
+        VK::pipelineCache = VK_NULL_HANDLE;
+    }
+};
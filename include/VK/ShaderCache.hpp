@@ -0,0 +1,75 @@
+#pragma once
+
+#include <volk.h>
+
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "Engine/Engine.hpp"
+
+// generated by CMake from assets/shaders/src
+#include "EmbeddedShaders.hpp"
+
+// Process-wide VkShaderModule cache. Modules are keyed by a hash of their
+// SPIR-V, so each shader is created once no matter how many pipelines (or
+// MSAA toggles) use it. Safe to call from the pipeline build jobs.
+namespace ShaderCache {
+    inline std::mutex mutex;
+    inline std::unordered_map<uint64_t, VkShaderModule> modules;
+    inline std::unordered_map<std::string, uint64_t> pathHashes;
+
+    inline VkShaderModule get(const char *path) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto known = pathHashes.find(path);
+            if (known != pathHashes.end()) return modules[known->second];
+        }
+
+        const uint32_t *code = nullptr;
+        size_t codeSize = 0;
+        for (const auto &shader : embeddedShaders) {
+            if (strcmp(shader.path, path) == 0) {
+                code = shader.code;
+                codeSize = shader.size;
+                break;
+            }
+        }
+        if (!code) {
+            throw std::runtime_error(std::string("no embedded shader ") + path);
+        }
+
+        uint64_t hash = Utils::hashBytes(code, codeSize);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = modules.find(hash);
+        if (it != modules.end()) {
+            pathHashes[path] = hash;
+            return it->second;
+        }
+
+        VkShaderModuleCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        createInfo.codeSize = codeSize;
+        createInfo.pCode = code;
+
+        VkShaderModule shaderModule;
+        if (vkCreateShaderModule(VK::device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shader module!");
+        }
+        // only now, so a failed create never leaves the path mapped to nothing
+        modules[hash] = shaderModule;
+        pathHashes[path] = hash;
+        return shaderModule;
+    }
+
+    inline void destroy() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &[hash, shaderModule] : modules) {
+            vkDestroyShaderModule(VK::device, shaderModule, nullptr);
+        }
+        modules.clear();
+        pathHashes.clear();
+    }
+};
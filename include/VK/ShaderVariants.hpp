@@ -0,0 +1,86 @@
+#pragma once
+
+#include <volk.h>
+
+#include <array>
+#include <vector>
+
+#include "Engine/Engine.hpp"
+
+// Material features that pick a main-pass pipeline. Normal/MR map bits map
+// onto specialization constants in shader.frag so the unused lighting paths
+// compile away. Skinned meshes use the same variants: they are skinned by
+// compute beforehand and drawn as plain Vertex streams.
+enum MaterialFeature : uint32_t {
+    MATERIAL_NORMAL_MAP = 1 << 0,
+    MATERIAL_MR_MAP     = 1 << 1,
+};
+#define MATERIAL_VARIANT_COUNT 4
+
+namespace ShaderVariants {
+    // layout(constant_id = N) in shader.frag
+    struct SpecializationData {
+        VkBool32 normalMap;
+        VkBool32 mrMap;
+        int32_t  pcfRadius;
+    };
+
+    inline const std::array<VkSpecializationMapEntry, 3> mapEntries = {{
+        {0, offsetof(SpecializationData, normalMap), sizeof(VkBool32)},
+        {1, offsetof(SpecializationData, mrMap),     sizeof(VkBool32)},
+        {2, offsetof(SpecializationData, pcfRadius), sizeof(int32_t)},
+    }};
+
+    inline SpecializationData specializationFor(uint32_t features, int pcfRadius) {
+        SpecializationData data{};
+        data.normalMap = (features & MATERIAL_NORMAL_MAP) ? VK_TRUE : VK_FALSE;
+        data.mrMap = (features & MATERIAL_MR_MAP) ? VK_TRUE : VK_FALSE;
+        data.pcfRadius = pcfRadius;
+        return data;
+    }
+
+    // Features a mesh needs, from the texture ids baked into its vertices
+    template<typename V>
+    inline uint32_t featuresFromVertices(const std::vector<V> &vertices) {
+        uint32_t features = 0;
+        for (const V &vertex : vertices) {
+            if (vertex.normalID >= 0) features |= MATERIAL_NORMAL_MAP;
+            if (vertex.metallicRoughnessID >= 0) features |= MATERIAL_MR_MAP;
+            if (features == (MATERIAL_NORMAL_MAP | MATERIAL_MR_MAP)) break;
+        }
+        return features;
+    }
+
+    // Pipelines indexed by feature bits, owned by the Renderer
+    inline std::array<VkPipeline, MATERIAL_VARIANT_COUNT> pipelines{};
+
+    // Set while the main pass records so Mesh3D::draw can switch variants;
+    // other passes (shadow, ui, sky) leave it null and keep their own pipeline.
+    inline VkCommandBuffer activeCommandBuffer = VK_NULL_HANDLE;
+    inline VkPipeline boundPipeline = VK_NULL_HANDLE;
+
+    inline uint32_t variantFor(uint32_t features) {
+        // the N/M toggle drops normal mapping globally
+        if (!Engine::enableNormal) features &= ~MATERIAL_NORMAL_MAP;
+        return features & (MATERIAL_VARIANT_COUNT - 1);
+    }
+
+    inline void begin(VkCommandBuffer commandBuffer) {
+        activeCommandBuffer = commandBuffer;
+        boundPipeline = VK_NULL_HANDLE;
+    }
+
+    inline void end() {
+        activeCommandBuffer = VK_NULL_HANDLE;
+        boundPipeline = VK_NULL_HANDLE;
+    }
+
+    // Binds the variant for these features unless it is already bound
+    inline void bind(uint32_t features) {
+        if (activeCommandBuffer == VK_NULL_HANDLE) return;
+        VkPipeline pipeline = pipelines[variantFor(features)];
+        if (pipeline == boundPipeline) return;
+        vkCmdBindPipeline(activeCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        boundPipeline = pipeline;
+    }
+};
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <volk.h>
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "Engine/Engine.hpp"
+#include "Engine/PoseMath.hpp"
+#include "Engine/Vertex.hpp"
+#include "VK/ShaderCache.hpp"
+
+// skinning.comp reads SkinnedVertex and writes Vertex as flat float streams,
+// so both must stay tightly packed (glm types without SIMD alignment)
+static_assert(sizeof(SkinnedVertex) == 26 * sizeof(float), "skinning.comp SRC_STRIDE out of date");
+static_assert(sizeof(Vertex) == 18 * sizeof(float), "skinning.comp DST_STRIDE out of date");
+static_assert(offsetof(SkinnedVertex, jointIndices) == 18 * sizeof(float), "skinning.comp joint offset out of date");
+
+// Compute skinning. All skinned meshes share three pooled buffers: source
+// SkinnedVertex data (one range per loaded model), bone palettes and skinned
+// output (one range per instance, both per frame in flight). skinning.comp
+// fills an instance's output once per frame and the shadow and main passes
+// then draw it like any static Vertex mesh. One descriptor set per frame
+// covers every instance; ranges are picked with push constants.
+namespace SkinningPass {
+    struct Range {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    // Free ranges of one pool, sorted by offset
+    struct RangePool {
+        const char *name;
+        uint32_t capacity = 0;
+        std::vector<Range> freeRanges;
+
+        void reset(uint32_t size) {
+            capacity = size;
+            freeRanges = {{0, size}};
+        }
+
+        // First fit; instances come and go in roughly the same sizes. False
+        // (and a warning) when no free range is big enough, so a spawn can
+        // fail without taking the game down.
+        bool allocate(uint32_t count, Range &range) {
+            for (size_t i = 0; i < freeRanges.size(); i++) {
+                Range &free = freeRanges[i];
+                if (free.count < count) continue;
+
+                range = {free.offset, count};
+                free.offset += count;
+                free.count -= count;
+                if (free.count == 0) freeRanges.erase(freeRanges.begin() + i);
+                return true;
+            }
+            Logger::warning("SkinningPass", (std::string("skinning ") + name + " pool is full (" +
+                                             std::to_string(capacity) + "), raise its size in config.h").c_str());
+            return false;
+        }
+
+        void release(Range range) {
+            if (range.count == 0) return;
+
+            auto it = freeRanges.begin();
+            while (it != freeRanges.end() && it->offset < range.offset) ++it;
+            it = freeRanges.insert(it, range);
+
+            // merge with the neighbours
+            auto next = it + 1;
+            if (next != freeRanges.end() && it->offset + it->count == next->offset) {
+                it->count += next->count;
+                freeRanges.erase(next);
+            }
+            if (it != freeRanges.begin()) {
+                auto prev = it - 1;
+                if (prev->offset + prev->count == it->offset) {
+                    prev->count += it->count;
+                    freeRanges.erase(it);
+                }
+            }
+        }
+    };
+
+    struct PushConstants {
+        uint32_t vertexCount;
+        uint32_t firstSource; // in vertices
+        uint32_t firstOutput; // in vertices
+        uint32_t firstBone;
+        uint32_t boneCount;
+    };
+
+    inline constexpr uint32_t GROUP_SIZE = 64; // local_size_x in skinning.comp
+
+    inline VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    inline VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    inline VkPipeline pipeline = VK_NULL_HANDLE;
+    inline VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    inline VkDescriptorSet descriptorSets[MAX_FRAMES_IN_FLIGHT]{};
+
+    // Source vertices only change when a model loads, so one device-local copy
+    inline VkBuffer sourceBuffer = VK_NULL_HANDLE;
+    inline VkDeviceMemory sourceMemory = VK_NULL_HANDLE;
+    // Palettes are written by the CPU every evaluation, persistently mapped
+    inline VkBuffer boneBuffers[MAX_FRAMES_IN_FLIGHT]{};
+    inline VkDeviceMemory boneMemories[MAX_FRAMES_IN_FLIGHT]{};
+    inline Affine3x4 *boneMapped[MAX_FRAMES_IN_FLIGHT]{};
+    inline VkBuffer outputBuffers[MAX_FRAMES_IN_FLIGHT]{};
+    inline VkDeviceMemory outputMemories[MAX_FRAMES_IN_FLIGHT]{};
+
+    // Source holds each cached model once, output every live instance
+    inline RangePool sourcePool{"source vertex"};
+    inline RangePool bonePool{"bone"};
+    inline RangePool outputPool{"vertex"};
+
+    // set 0: source SkinnedVertex[], bone palette, output Vertex[]
+    inline void createSetLayout() {
+        VkDescriptorSetLayoutBinding bindings[3]{};
+        for (uint32_t i = 0; i < 3; i++) {
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo info{};
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        info.bindingCount = 3;
+        info.pBindings = bindings;
+
+        if (vkCreateDescriptorSetLayout(VK::device, &info, nullptr, &setLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create skinning descriptor set layout!");
+        }
+    }
+
+    inline void createPipeline() {
+        VkPushConstantRange pushRange{};
+        pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushRange.size = sizeof(PushConstants);
+
+        VkPipelineLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layoutInfo.setLayoutCount = 1;
+        layoutInfo.pSetLayouts = &setLayout;
+        layoutInfo.pushConstantRangeCount = 1;
+        layoutInfo.pPushConstantRanges = &pushRange;
+
+        if (vkCreatePipelineLayout(VK::device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create skinning pipeline layout!");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = ShaderCache::get("assets/shaders/skinning.comp.spv");
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+
+        if (vkCreateComputePipelines(VK::device, VK::pipelineCache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create skinning pipeline!");
+        }
+    }
+
+    inline void createDescriptorSets() {
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount = 3 * MAX_FRAMES_IN_FLIGHT;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
+
+        if (vkCreateDescriptorPool(VK::device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create skinning descriptor pool!");
+        }
+
+        VkDescriptorSetLayout layouts[MAX_FRAMES_IN_FLIGHT];
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) layouts[i] = setLayout;
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = MAX_FRAMES_IN_FLIGHT;
+        allocInfo.pSetLayouts = layouts;
+
+        if (vkAllocateDescriptorSets(VK::device, &allocInfo, descriptorSets) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate skinning descriptor sets!");
+        }
+
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            VkDescriptorBufferInfo bufferInfos[3] = {
+                {sourceBuffer, 0, VK_WHOLE_SIZE},
+                {boneBuffers[i], 0, VK_WHOLE_SIZE},
+                {outputBuffers[i], 0, VK_WHOLE_SIZE},
+            };
+
+            VkWriteDescriptorSet writes[3]{};
+            for (uint32_t b = 0; b < 3; b++) {
+                writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[b].dstSet = descriptorSets[i];
+                writes[b].dstBinding = b;
+                writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writes[b].descriptorCount = 1;
+                writes[b].pBufferInfo = &bufferInfos[b];
+            }
+            vkUpdateDescriptorSets(VK::device, 3, writes, 0, nullptr);
+        }
+    }
+
+    inline void init() {
+        createSetLayout();
+        createPipeline();
+
+        Memory::createBuffer(sizeof(SkinnedVertex) * (VkDeviceSize) SKINNING_POOL_SOURCE_VERTICES,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, sourceBuffer, sourceMemory);
+
+        VkDeviceSize boneSize = sizeof(Affine3x4) * (VkDeviceSize) SKINNING_POOL_BONES;
+        VkDeviceSize outputSize = sizeof(Vertex) * (VkDeviceSize) SKINNING_POOL_VERTICES;
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            Memory::createBuffer(boneSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                boneBuffers[i], boneMemories[i]);
+            void *mapped;
+            vkMapMemory(VK::device, boneMemories[i], 0, boneSize, 0, &mapped);
+            boneMapped[i] = static_cast<Affine3x4 *>(mapped);
+
+            Memory::createBuffer(outputSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, outputBuffers[i], outputMemories[i]);
+        }
+
+        createDescriptorSets();
+
+        sourcePool.reset(SKINNING_POOL_SOURCE_VERTICES);
+        bonePool.reset(SKINNING_POOL_BONES);
+        outputPool.reset(SKINNING_POOL_VERTICES);
+    }
+
+    inline void destroy() {
+        vkDestroyBuffer(VK::device, sourceBuffer, nullptr);
+        vkFreeMemory(VK::device, sourceMemory, nullptr);
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            vkDestroyBuffer(VK::device, boneBuffers[i], nullptr);
+            vkFreeMemory(VK::device, boneMemories[i], nullptr);
+            boneMapped[i] = nullptr;
+            vkDestroyBuffer(VK::device, outputBuffers[i], nullptr);
+            vkFreeMemory(VK::device, outputMemories[i], nullptr);
+        }
+        vkDestroyDescriptorPool(VK::device, descriptorPool, nullptr);
+        vkDestroyPipeline(VK::device, pipeline, nullptr);
+        vkDestroyPipelineLayout(VK::device, pipelineLayout, nullptr);
+        vkDestroyDescriptorSetLayout(VK::device, setLayout, nullptr);
+    }
+
+    // Uploads a model's vertices into its source range
+    inline void uploadSource(Range range, const SkinnedVertex *vertices) {
+        VkDeviceSize size = sizeof(SkinnedVertex) * (VkDeviceSize) range.count;
+        VkBuffer staging;
+        VkDeviceMemory stagingMemory;
+        Memory::createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            staging, stagingMemory);
+
+        void *data;
+        vkMapMemory(VK::device, stagingMemory, 0, size, 0, &data);
+        memcpy(data, vertices, size);
+        vkUnmapMemory(VK::device, stagingMemory);
+
+        Memory::copyBuffer(staging, sourceBuffer, size, sizeof(SkinnedVertex) * (VkDeviceSize) range.offset);
+
+        vkDestroyBuffer(VK::device, staging, nullptr);
+        vkFreeMemory(VK::device, stagingMemory, nullptr);
+    }
+
+    inline Affine3x4 *palette(int frameIndex, Range range) {
+        return boneMapped[frameIndex] + range.offset;
+    }
+
+    // Binds the pipeline and this frame's set for the dispatches that follow
+    inline void begin(VkCommandBuffer commandBuffer, int frameIndex) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                pipelineLayout, 0, 1, &descriptorSets[frameIndex], 0, nullptr);
+    }
+
+    // Skinned vertices are read as vertex input by the shadow and main passes
+    inline void barrier(VkCommandBuffer commandBuffer, int frameIndex) {
+        VkBufferMemoryBarrier bufferBarrier{};
+        bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        bufferBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        bufferBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        bufferBarrier.buffer = outputBuffers[frameIndex];
+        bufferBarrier.offset = 0;
+        bufferBarrier.size = VK_WHOLE_SIZE;
+
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+    }
+};
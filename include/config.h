@@ -18,4 +18,65 @@
 
 #define ENABLE_SHADOWS
 
-#define ENABLE_VULKAN_12_FEATURES
\ No newline at end of file
+#define ENABLE_VULKAN_12_FEATURES
+
+// on-disk VkPipelineCache, relative to the working directory
+#define PIPELINE_CACHE_PATH "pipeline_cache.bin"
+
+// shadow PCF kernel radius in texels (0 = single tap, 1 = 3x3, 2 = 5x5)
+#define SHADOW_PCF_RADIUS 1
+
+// resample animation tracks to this many evenly spaced keys per second at
+// load time (0 = keep the source keys)
+#define ANIM_RESAMPLE_RATE 0
+
+// skinned animation LOD by projected height (fraction of the screen height):
+// below each size the pose is updated half as often, and from LOD 2 joints
+// with less than ANIM_LOD_MIN_JOINT_INFLUENCE of the skin weight follow their parent
+#define ANIM_LOD_SCREEN_SIZE_1 0.15f
+#define ANIM_LOD_SCREEN_SIZE_2 0.07f
+#define ANIM_LOD_SCREEN_SIZE_3 0.03f
+#define ANIM_LOD_MIN_JOINT_INFLUENCE 0.002f
+
+// vertices in the shared compute-skinning pools: each live instance takes its
+// model's vertex count from the output pool (per frame in flight), enough for
+// a 200-character horde of ~3k-vertex rigs like male_07; each loaded skinned
+// model takes it once from the source pool. A spawn that doesn't fit fails.
+#define SKINNING_POOL_VERTICES (1 << 20)
+#define SKINNING_POOL_SOURCE_VERTICES (1 << 19)
+// bone matrices in the shared palette pool (per frame in flight); each live
+// instance takes one per joint
+#define SKINNING_POOL_BONES (1 << 16)
+
+// frames per second of clips baked for CrowdMesh3D; crowd members step
+// between baked frames, so this trades smoothness against vertex memory
+#define VAT_BAKE_RATE 20.0f
+
+// fixed physics step rate; a frame runs at most PHYSICS_MAX_SUBSTEPS steps
+// and drops the rest, so physics cost per second stays bounded when the
+// frame rate collapses
+#define PHYSICS_HZ 60.0f
+#define PHYSICS_MAX_SUBSTEPS 4
+
+// Bullet task scheduler threads with VORPAL_PHYSICS_MT, 0 = all cores but one
+#define PHYSICS_THREADS 0
+
+// a body resting below these speeds (m/s, rad/s) for 2s falls asleep with its island
+#define PHYSICS_SLEEP_LINEAR 0.8f
+#define PHYSICS_SLEEP_ANGULAR 1.0f
+
+// dynamic bodies below this height are put back at the spawn point
+#define PHYSICS_KILL_Y -20.0f
+
+// baked convex hulls and trimesh BVHs, see ShapeCache.hpp
+#define SHAPE_CACHE_DIR "shape_cache"
+
+// collision hulls: point budget per hull, and for DECOMPOSED colliders the
+// part budget and how much hull volume a split must save to be worth it
+#define HULL_MAX_VERTICES 32
+#define DECOMPOSITION_MAX_PARTS 16
+#define DECOMPOSITION_CONCAVITY 0.1f
+
+// Removed bodies kept (disabled) in the physics world per collision shape,
+// handed to the next body registered with the same shape
+#define PHYSICS_PARKED_PER_SHAPE 16
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "Engine/CrowdMesh3D.hpp"
+#include "Engine/Engine.hpp"
+#include "VK/ShaderVariants.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+void CrowdMesh3D::init(const char* filename, int clip) {
+    geom = SkinnedMesh3D::acquireGeometry(filename);
+    baked = &SkinnedMesh3D::bakeClip(*geom, clip);
+    materialFeatures = geom->materialFeatures;
+}
+
+void CrowdMesh3D::destroy() {
+    if (geom) {
+        // baked clips are released with the geometry
+        SkinnedMesh3D::releaseGeometry(geom);
+        geom = nullptr;
+        baked = nullptr;
+    }
+    members.clear();
+}
+
+int CrowdMesh3D::addMember(glm::vec3 offset, float yaw, float timeOffset) {
+    members.push_back({offset, yaw, timeOffset});
+    membersDirty = true;
+    return (int)members.size() - 1;
+}
+
+int CrowdMesh3D::addMember(glm::vec3 offset, float yaw) {
+    float duration = baked ? baked->duration : 0.0f;
+    return addMember(offset, yaw, duration * (float)(rand() % 1000) / 1000.0f);
+}
+
+void CrowdMesh3D::setMember(int index, glm::vec3 offset, float yaw) {
+    if (index < 0 || index >= (int)members.size()) return;
+    members[index].offset = offset;
+    members[index].yaw = yaw;
+    membersDirty = true;
+}
+
+void CrowdMesh3D::updateMatrices() {
+    glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), scale);
+    for (Member& member : members) {
+        glm::vec3 worldPos = position + orientation * member.offset;
+        member.model = glm::translate(glm::mat4(1.0f), worldPos * glm::vec3(WORLD_SCALE))
+                     * glm::toMat4(orientation)
+                     * glm::toMat4(glm::angleAxis(member.yaw, glm::vec3(0.0f, 1.0f, 0.0f)))
+                     * scaleMatrix;
+    }
+    isDirty = false;
+    membersDirty = false;
+}
+
+void CrowdMesh3D::draw(VkCommandBuffer commandBuffer, VkPipelineLayout layout, Frustum* frustum) {
+    if (!visible || !baked || members.empty()) return;
+    if (isDirty || membersDirty) updateMatrices();
+
+    ShaderVariants::bind(materialFeatures);
+
+    // Every frame of the clip lives in one buffer, members only pick theirs
+    // through vertexOffset
+    VkBuffer vbs[] = { baked->buffer };
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vbs, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, geom->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+    uint32_t indexCount = (uint32_t)geom->indices.size();
+    uint32_t vertexCount = (uint32_t)geom->vertices.size();
+
+    // bounding sphere in render space (shader scales glTF units by 0.01)
+    float radius = glm::length(geom->BB - geom->AA) * 0.5f * 0.01f
+                 * std::max({scale.x, scale.y, scale.z});
+
+    ModelBufferObject mbo{};
+    mbo.metallic = metallic;
+    mbo.roughness = roughness;
+    for (const Member& member : members) {
+        if (frustum) {
+            glm::vec3 center = glm::vec3(member.model * glm::vec4(geom->modelCenter * 0.01f, 1.0f));
+            if (!frustum->IsBoxVisible(center - glm::vec3(radius), center + glm::vec3(radius))) continue;
+        }
+
+        uint32_t frame = 0;
+        if (baked->duration > 0.0f) {
+            float t = std::fmod(time + member.timeOffset, baked->duration);
+            if (t < 0.0f) t += baked->duration;
+            frame = std::min((uint32_t)(t * baked->frameRate), baked->frameCount - 1);
+        }
+
+        mbo.model = member.model;
+        vkCmdPushConstants(commandBuffer, layout, VK_SHADER_STAGE_VERTEX_BIT,
+                           0, sizeof(ModelBufferObject), &mbo);
+        vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, (int32_t)(frame * vertexCount), 0);
+    }
+}
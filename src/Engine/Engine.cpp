@@ -9,11 +9,15 @@
 #define TINYGLTF_IMPLEMENTATION
 #include "tiny_gltf.h"
 
+#include <mutex>
+
 mz_zip_archive zip;
 std::vector<uint8_t> zipBuffer;
-std::vector<char> fileData;
+// texture decode workers read from the archive too, miniz keeps its error state in the archive
+std::mutex zipMutex;
 
 std::vector<char> Utils::readFileZip(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(zipMutex);
     int fileIndex = mz_zip_reader_locate_file(const_cast<mz_zip_archive*>(&zip), filename.c_str(), nullptr, 0);
     if (fileIndex < 0) {
         printf("Error: File not found: %s\n", filename.c_str());
@@ -27,7 +31,7 @@ std::vector<char> Utils::readFileZip(const std::string& filename) {
         throw std::runtime_error("Failed to get file stats");
     }
 
-    fileData.resize(stat.m_uncomp_size);
+    std::vector<char> fileData(stat.m_uncomp_size);
     
     if (!mz_zip_reader_extract_to_mem(const_cast<mz_zip_archive*>(&zip), fileIndex, fileData.data(), fileData.size(), 0)) {
         printf("Error: Failed to extract file data for index %i\n", fileIndex);
@@ -37,6 +41,7 @@ std::vector<char> Utils::readFileZip(const std::string& filename) {
     return fileData;
 }
 bool Utils::fileExistsZip(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(zipMutex);
     bool exists = mz_zip_reader_locate_file(const_cast<mz_zip_archive*>(&zip), filename.c_str(), nullptr, 0) >= 0;
     return exists;
 }
@@ -99,7 +99,14 @@ void LuaManager::bindEngine(sol::state& lua) {
     lua.new_enum("ColliderType",
         "BOX",       ColliderType::BOX,
         "CONVEXHULL",ColliderType::CONVEXHULL,
-        "TRIMESH",   ColliderType::TRIMESH
+        "TRIMESH",   ColliderType::TRIMESH,
+        "DECOMPOSED",ColliderType::DECOMPOSED
+    );
+
+    lua.new_enum("ActivationPolicy",
+        "AUTO",   ActivationPolicy::ACTIVATION_AUTO,
+        "ALWAYS", ActivationPolicy::ACTIVATION_ALWAYS,
+        "ASLEEP", ActivationPolicy::ACTIVATION_ASLEEP
     );
 
     // -------------------------------------------------------------------------
@@ -126,7 +133,12 @@ void LuaManager::bindEngine(sol::state& lua) {
         "getPhysicsPosition", &Mesh3D::getPhysicsPosition,
         "setFriction",        &Mesh3D::setFriction,
         "setRestitution",     &Mesh3D::setRestitution,
-        "setDamping",         &Mesh3D::setDamping
+        "setDamping",         &Mesh3D::setDamping,
+        "setActivationPolicy", &Mesh3D::setActivationPolicy,
+        "getActivationPolicy", &Mesh3D::getActivationPolicy,
+        "wake",               &Mesh3D::wake,
+        "isSleeping",         &Mesh3D::isSleeping,
+        "getBodyId",          &Mesh3D::getBodyId
     );
 
     // -------------------------------------------------------------------------
@@ -145,11 +157,58 @@ void LuaManager::bindEngine(sol::state& lua) {
         "getTestBoneIndex", &SkinnedMesh3D::getTestBoneIndex,
         "getAnimCount",     &SkinnedMesh3D::getAnimCount,
         "getAnimTime",      &SkinnedMesh3D::getAnimTime,
+        "crossFade",        &SkinnedMesh3D::crossFade,
+        "playLayer", sol::overload(
+            [](SkinnedMesh3D& m, int layer, int index) { m.playLayer(layer, index, 0.0f); },
+            [](SkinnedMesh3D& m, int layer, int index, float fade) { m.playLayer(layer, index, fade); }
+        ),
+        "stopLayer", sol::overload(
+            [](SkinnedMesh3D& m, int layer) { m.stopLayer(layer, 0.0f); },
+            [](SkinnedMesh3D& m, int layer, float fade) { m.stopLayer(layer, fade); }
+        ),
+        "setLayerWeight",   &SkinnedMesh3D::setLayerWeight,
+        "setLayerAdditive", &SkinnedMesh3D::setLayerAdditive,
+        "setLayerLooping",  &SkinnedMesh3D::setLayerLooping,
+        "setLayerMask",     &SkinnedMesh3D::setLayerMask,
+        "clearLayerMask",   &SkinnedMesh3D::clearLayerMask,
+        "findJoint",        &SkinnedMesh3D::findJoint,
         "createCapsuleRigidBody", sol::overload(
             [](SkinnedMesh3D& m, float mass) { m.createCapsuleRigidBody(mass); },
             [](SkinnedMesh3D& m, float mass, float radius) { m.createCapsuleRigidBody(mass, radius); },
             [](SkinnedMesh3D& m, float mass, float radius, float height) { m.createCapsuleRigidBody(mass, radius, height); }
-        )
+        ),
+        "createCharacterController", sol::overload(
+            [](SkinnedMesh3D& m) { m.createCharacterController(); },
+            [](SkinnedMesh3D& m, float radius, float height) { m.createCharacterController(radius, height); },
+            [](SkinnedMesh3D& m, float radius, float height, float stepHeight) { m.createCharacterController(radius, height, stepHeight); },
+            [](SkinnedMesh3D& m, float radius, float height, float stepHeight, float maxSlopeDegrees) {
+                m.createCharacterController(radius, height, stepHeight, maxSlopeDegrees);
+            }
+        ),
+        "setWalkVelocity",  &SkinnedMesh3D::setWalkVelocity,
+        "jump",             &SkinnedMesh3D::jump,
+        "teleport",         &SkinnedMesh3D::teleport,
+        "isGrounded",       &SkinnedMesh3D::isGrounded
+    );
+
+    // -------------------------------------------------------------------------
+    // CrowdMesh3D — baked-animation crowd, created with scene:create_crowd
+    // -------------------------------------------------------------------------
+    lua.new_usertype<CrowdMesh3D>("CrowdMesh3D",
+        "setPosition",    &CrowdMesh3D::setPosition,
+        "setRotation",    &CrowdMesh3D::setRotation,
+        "setScale",       &CrowdMesh3D::setScale,
+        "setVisible",     &CrowdMesh3D::setVisible,
+        "isVisible",      &CrowdMesh3D::isVisible,
+        "addMember", sol::overload(
+            [](CrowdMesh3D& c, glm::vec3 offset, float yaw) { return c.addMember(offset, yaw); },
+            [](CrowdMesh3D& c, glm::vec3 offset, float yaw, float timeOffset) { return c.addMember(offset, yaw, timeOffset); }
+        ),
+        "setMember",      &CrowdMesh3D::setMember,
+        "clearMembers",   &CrowdMesh3D::clearMembers,
+        "getMemberCount", &CrowdMesh3D::getMemberCount,
+        "setSpeed",       &CrowdMesh3D::setSpeed,
+        "getSpeed",       &CrowdMesh3D::getSpeed
     );
 
     // -------------------------------------------------------------------------
@@ -163,7 +222,8 @@ void LuaManager::bindEngine(sol::state& lua) {
         "getUp",          &Camera::getUp,
         "getVelocity",    &Camera::getVelocity,
         "getOrientation", &Camera::getOrientation,
-        "setOrientation", &Camera::setOrientation
+        "setOrientation", &Camera::setOrientation,
+        "getBodyId",      &Camera::getBodyId
     );
 
     // -------------------------------------------------------------------------
@@ -177,6 +237,102 @@ void LuaManager::bindEngine(sol::state& lua) {
         "getHeight",      &Window::getHeight
     );
 
+    // -------------------------------------------------------------------------
+    // QueryBatch — rays, sweeps and overlaps run together after the next
+    // physics step (scene:submit_queries). add_* return 1-based indices into
+    // the flat result arrays; points/normals hold x, y, z per query. Bodies
+    // are getBodyId() values, -1 for none.
+    // -------------------------------------------------------------------------
+    using Physics::QueryBatch;
+    auto toTable = [](sol::this_state s, const auto& values) {
+        sol::state_view view(s);
+        sol::table t = view.create_table((int)values.size(), 0);
+        for (size_t i = 0; i < values.size(); i++) t[i + 1] = values[i];
+        return t;
+    };
+    auto toFlatTable = [](sol::this_state s, const std::vector<btVector3>& values, bool positions) {
+        sol::state_view view(s);
+        sol::table t = view.create_table((int)values.size() * 3, 0);
+        for (size_t i = 0; i < values.size(); i++) {
+            glm::vec3 v = positions ? physicsToWorld(values[i])
+                                    : glm::vec3(values[i].getX(), values[i].getY(), values[i].getZ());
+            t[i * 3 + 1] = v.x;
+            t[i * 3 + 2] = v.y;
+            t[i * 3 + 3] = v.z;
+        }
+        return t;
+    };
+
+    lua.new_usertype<QueryBatch>("QueryBatch",
+        "new", sol::factories([]() { return std::make_shared<QueryBatch>(); }),
+        "addRay", sol::overload(
+            [](QueryBatch& b, glm::vec3 from, glm::vec3 to) {
+                return b.addRay(worldToPhysics(from), worldToPhysics(to)) + 1;
+            },
+            [](QueryBatch& b, glm::vec3 from, glm::vec3 to, int ignore) {
+                return b.addRay(worldToPhysics(from), worldToPhysics(to), ignore) + 1;
+            }
+        ),
+        "addSphereSweep", sol::overload(
+            [](QueryBatch& b, glm::vec3 from, glm::vec3 to, float radius) {
+                return b.addSphereSweep(worldToPhysics(from), worldToPhysics(to), radius) + 1;
+            },
+            [](QueryBatch& b, glm::vec3 from, glm::vec3 to, float radius, int ignore) {
+                return b.addSphereSweep(worldToPhysics(from), worldToPhysics(to), radius, ignore) + 1;
+            }
+        ),
+        "addCapsuleSweep", sol::overload(
+            [](QueryBatch& b, glm::vec3 from, glm::vec3 to, float radius, float height) {
+                return b.addCapsuleSweep(worldToPhysics(from), worldToPhysics(to), radius, height) + 1;
+            },
+            [](QueryBatch& b, glm::vec3 from, glm::vec3 to, float radius, float height, int ignore) {
+                return b.addCapsuleSweep(worldToPhysics(from), worldToPhysics(to), radius, height, ignore) + 1;
+            }
+        ),
+        "addSphereOverlap", sol::overload(
+            [](QueryBatch& b, glm::vec3 center, float radius) {
+                return b.addSphereOverlap(worldToPhysics(center), radius) + 1;
+            },
+            [](QueryBatch& b, glm::vec3 center, float radius, int ignore) {
+                return b.addSphereOverlap(worldToPhysics(center), radius, ignore) + 1;
+            }
+        ),
+        "addCapsuleOverlap", sol::overload(
+            [](QueryBatch& b, glm::vec3 center, float radius, float height) {
+                return b.addCapsuleOverlap(worldToPhysics(center), radius, height) + 1;
+            },
+            [](QueryBatch& b, glm::vec3 center, float radius, float height, int ignore) {
+                return b.addCapsuleOverlap(worldToPhysics(center), radius, height, ignore) + 1;
+            }
+        ),
+        "clear",      &QueryBatch::clear,
+        "size",       &QueryBatch::size,
+        "isReady",    &QueryBatch::isReady,
+        "isPending",  &QueryBatch::isPending,
+        "hits", [](const QueryBatch& b, sol::this_state s) {
+            b.checkReadable();
+            sol::state_view view(s);
+            sol::table t = view.create_table((int)b.hit.size(), 0);
+            for (size_t i = 0; i < b.hit.size(); i++) t[i + 1] = b.hit[i] != 0;
+            return t;
+        },
+        "fractions", [toTable](const QueryBatch& b, sol::this_state s) { b.checkReadable(); return toTable(s, b.fraction); },
+        "bodies",    [toTable](const QueryBatch& b, sol::this_state s) { b.checkReadable(); return toTable(s, b.body); },
+        "points",    [toFlatTable](const QueryBatch& b, sol::this_state s) { b.checkReadable(); return toFlatTable(s, b.point, true); },
+        "normals",   [toFlatTable](const QueryBatch& b, sol::this_state s) { b.checkReadable(); return toFlatTable(s, b.normal, false); },
+        // every body an overlap query touched
+        "overlaps", [toTable](const QueryBatch& b, int index, sol::this_state s) {
+            b.checkReadable();
+            std::vector<int> ids;
+            int i = index - 1;
+            if (i >= 0 && i < (int)b.overlapStart.size()) {
+                auto first = b.overlapBodies.begin() + b.overlapStart[i];
+                ids.assign(first, first + b.overlapCount[i]);
+            }
+            return toTable(s, ids);
+        }
+    );
+
     // -------------------------------------------------------------------------
     // Scene
     // -------------------------------------------------------------------------
@@ -186,7 +342,10 @@ void LuaManager::bindEngine(sol::state& lua) {
         "create_skinned_object", &Scene::create_skinned_object,
         "remove_object",         &Scene::remove_object,
         "remove_skinned_object", &Scene::remove_skinned_object,
+        "create_crowd",          &Scene::create_crowd,
+        "remove_crowd",          &Scene::remove_crowd,
         "registerPhysics",       &Scene::registerPhysics,
+        "submit_queries",        &Scene::submit_queries,
         "load_lua_scene",        &Scene::load_lua_scene,
         "handleUIInteraction",   &Scene::handleUIInteraction,
         "camera",                &Scene::camera,
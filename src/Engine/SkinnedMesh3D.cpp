@@ -1,5 +1,11 @@
 #include "Engine/SkinnedMesh3D.hpp"
 #include "Engine/Engine.hpp"
+#include "Engine/TextureAtlas.hpp"
+#include "Engine/JobSystem.hpp"
+#include "Engine/ShapeCache.hpp"
+#include "Engine/BodyPool.hpp"
+#include "Engine/CharacterController.hpp"
+#include "VK/ShaderVariants.hpp"
 
 // tinygltf is already implemented in Engine.cpp
 #include "tiny_gltf.h"
@@ -12,8 +18,9 @@
 
 // ---- Vulkan buffer helpers (reuse engine helpers) -------------------------
 
-void SkinnedMesh3D::createVertexBuffer() {
-    VkDeviceSize size = sizeof(SkinnedVertex) * m_skinnedVertices.size();
+void SkinnedMesh3D::createIndexBuffer(SharedSkinnedGeometry& geom) {
+    const std::vector<uint32_t>& indices = geom.indices;
+    VkDeviceSize size = sizeof(uint32_t) * indices.size();
     VkBuffer staging; VkDeviceMemory stagingMem;
     Memory::createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
@@ -21,115 +28,56 @@ void SkinnedMesh3D::createVertexBuffer() {
 
     void* data;
     vkMapMemory(VK::device, stagingMem, 0, size, 0, &data);
-    memcpy(data, m_skinnedVertices.data(), size);
-    vkUnmapMemory(VK::device, stagingMem);
-
-    Memory::createBuffer(size,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
-    Memory::copyBuffer(staging, vertexBuffer, size);
-
-    vkDestroyBuffer(VK::device, staging, nullptr);
-    vkFreeMemory(VK::device, stagingMem, nullptr);
-}
-
-void SkinnedMesh3D::createIndexBuffer() {
-    VkDeviceSize size = sizeof(uint32_t) * m_indices.size();
-    VkBuffer staging; VkDeviceMemory stagingMem;
-    Memory::createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        staging, stagingMem);
-
-    void* data;
-    vkMapMemory(VK::device, stagingMem, 0, size, 0, &data);
-    memcpy(data, m_indices.data(), size);
+    memcpy(data, indices.data(), size);
     vkUnmapMemory(VK::device, stagingMem);
 
     Memory::createBuffer(size,
         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
-    Memory::copyBuffer(staging, indexBuffer, size);
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, geom.indexBuffer, geom.indexBufferMemory);
+    Memory::copyBuffer(staging, geom.indexBuffer, size);
 
     vkDestroyBuffer(VK::device, staging, nullptr);
     vkFreeMemory(VK::device, stagingMem, nullptr);
 }
 
-void SkinnedMesh3D::createBoneBuffers() {
-    VkDeviceSize size = sizeof(glm::mat4) * MAX_BONES;
-
-    // Per-frame persistently-mapped SSBOs
-    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        Memory::createBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            boneBuffers[i], boneBufferMemories[i]);
-        vkMapMemory(VK::device, boneBufferMemories[i], 0, size, 0, &boneMappedPtrs[i]);
-
-        // Fill with identity matrices so un-animated bones don't corrupt geometry
-        std::vector<glm::mat4> idents(MAX_BONES, glm::mat4(1.0f));
-        memcpy(boneMappedPtrs[i], idents.data(), size);
-    }
-
-    // Each skinned mesh owns a tiny descriptor pool (2 sets, one per frame)
-    VkDescriptorPoolSize poolSize{};
-    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    poolSize.descriptorCount = MAX_FRAMES_IN_FLIGHT;
-
-    VkDescriptorPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = 1;
-    poolInfo.pPoolSizes = &poolSize;
-    poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
-    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-
-    if (vkCreateDescriptorPool(VK::device, &poolInfo, nullptr, &boneDescriptorPool) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create bone descriptor pool");
-
-    // Allocate descriptor sets from this pool using the global bone layout
-    std::array<VkDescriptorSetLayout, MAX_FRAMES_IN_FLIGHT> layouts;
-    layouts.fill(VK::boneDescriptorSetLayout);
-
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = boneDescriptorPool;
-    allocInfo.descriptorSetCount = MAX_FRAMES_IN_FLIGHT;
-    allocInfo.pSetLayouts = layouts.data();
+// ---- Texture loading (mirrors the logic in Assets::loadModel) -------------
 
-    if (vkAllocateDescriptorSets(VK::device, &allocInfo, boneDescriptorSets) != VK_SUCCESS)
-        throw std::runtime_error("Failed to allocate bone descriptor sets");
+// Texture key for a glTF texture: zip path for external images, generated name otherwise
+static std::string texturePath(const tinygltf::Model& model, int textureIndex,
+                               const std::string& nameSuffix, bool& isEmbedded) {
+    const tinygltf::Image& image = model.images[model.textures[textureIndex].source];
+    isEmbedded = image.uri.empty();
+    if (!isEmbedded)                  return "assets/textures/" + image.uri;
+    if (!image.name.empty())          return image.name + nameSuffix;
+    return "skinned_mat_" + std::to_string(textureIndex) + nameSuffix;
+}
 
-    // Point each descriptor set at its frame's SSBO
-    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        VkDescriptorBufferInfo bufInfo{};
-        bufInfo.buffer = boneBuffers[i];
-        bufInfo.offset = 0;
-        bufInfo.range  = size;
+static bool hasImage(const tinygltf::Model& model, int textureIndex) {
+    if (textureIndex < 0) return false;
+    int sourceIndex = model.textures[textureIndex].source;
+    return sourceIndex >= 0 && sourceIndex < (int)model.images.size();
+}
 
-        VkWriteDescriptorSet write{};
-        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        write.dstSet = boneDescriptorSets[i];
-        write.dstBinding = 0;
-        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        write.descriptorCount = 1;
-        write.pBufferInfo = &bufInfo;
-        vkUpdateDescriptorSets(VK::device, 1, &write, 0, nullptr);
+static void queueTexture(const tinygltf::Model& model, int textureIndex, const std::string& nameSuffix,
+                         VkFormat fmt, std::vector<TextureLoadRequest>& requests) {
+    if (!hasImage(model, textureIndex)) return;
+    TextureLoadRequest req;
+    bool isEmbedded;
+    req.path = texturePath(model, textureIndex, nameSuffix, isEmbedded);
+    if (isEmbedded) {
+        req.image  = &model.images[model.textures[textureIndex].source];
+        req.format = fmt;
     }
+    requests.push_back(req);
 }
 
-// ---- Texture loading (mirrors the logic in Assets::loadModel) -------------
-
 static int loadOrGetTexture(const tinygltf::Model& model, int textureIndex,
                             const std::string& nameSuffix, VkFormat fmt) {
-    if (textureIndex < 0) return -1;
-    int sourceIndex = model.textures[textureIndex].source;
-    if (sourceIndex < 0 || sourceIndex >= (int)model.images.size()) return -1;
-
-    const tinygltf::Image& image = model.images[sourceIndex];
-    std::string texPath;
-    bool isEmbedded = true;
+    if (!hasImage(model, textureIndex)) return -1;
 
-    if (!image.name.empty())          texPath = image.name + nameSuffix;
-    else                              texPath = "skinned_mat_" + std::to_string(textureIndex) + nameSuffix;
-    if (!image.uri.empty())         { texPath = "assets/textures/" + image.uri; isEmbedded = false; }
+    const tinygltf::Image& image = model.images[model.textures[textureIndex].source];
+    bool isEmbedded;
+    std::string texPath = texturePath(model, textureIndex, nameSuffix, isEmbedded);
 
     auto it = std::find(VK::g_texturePathList.begin(), VK::g_texturePathList.end(), texPath);
     if (it != VK::g_texturePathList.end())
@@ -148,9 +96,216 @@ static int loadOrGetTexture(const tinygltf::Model& model, int textureIndex,
     return id;
 }
 
+// ---- Animation clips ------------------------------------------------------
+
+// Finds the key interval [idx, idx + 1] containing time, which the caller
+// keeps strictly inside the track. Evenly spaced keys are indexed directly;
+// otherwise the search starts at the cursor left by the previous frame and
+// only falls back to a binary search after a loop, seek or clip change.
+static uint32_t findKey(const AnimTrack& track, const float* times, float time, uint32_t& cursor) {
+    uint32_t lastInterval = track.keyCount - 2;
+    uint32_t idx;
+
+    if (track.invInterval > 0.0f) {
+        idx = std::min((uint32_t)((time - times[0]) * track.invInterval), lastInterval);
+        // absorb rounding in the stored key times
+        if (idx > 0 && times[idx] > time) idx--;
+        else if (idx < lastInterval && times[idx + 1] <= time) idx++;
+        return idx;
+    }
+
+    idx = cursor;
+    bool search = idx > lastInterval || times[idx] > time;
+    // a frame rarely crosses more than a couple of keys
+    for (int steps = 0; !search && idx < lastInterval && times[idx + 1] <= time; steps++) {
+        if (steps == 4) search = true;
+        else idx++;
+    }
+    if (search) {
+        idx = (uint32_t)(std::upper_bound(times, times + track.keyCount, time) - times) - 1;
+    }
+    cursor = idx;
+    return idx;
+}
+
+static glm::vec4 sampleTrack(const AnimClip& clip, const AnimTrack& track, float time, uint32_t& cursor) {
+    const float* times = &clip.times[track.firstKey];
+    const glm::vec4* values = &clip.values[track.firstValue];
+    uint32_t last = track.keyCount - 1;
+
+    if (track.interpolation == AnimInterpolation::CubicSpline) {
+        // keys are [in-tangent, value, out-tangent]
+        if (last == 0 || time <= times[0]) return values[1];
+        if (time >= times[last]) return values[last * 3 + 1];
+    } else {
+        if (last == 0 || time <= times[0]) return values[0];
+        if (time >= times[last]) return values[last];
+    }
+
+    uint32_t idx = findKey(track, times, time, cursor);
+    float t0 = times[idx];
+    float t1 = times[idx + 1];
+    float dt = t1 - t0;
+    float s  = dt > 0.0f ? glm::clamp((time - t0) / dt, 0.0f, 1.0f) : 0.0f;
+
+    switch (track.interpolation) {
+    case AnimInterpolation::Step:
+        return values[idx];
+    case AnimInterpolation::Linear:
+        if (track.path == AnimPath::Rotation) {
+            glm::quat q0(values[idx].w, values[idx].x, values[idx].y, values[idx].z);
+            glm::quat q1(values[idx + 1].w, values[idx + 1].x, values[idx + 1].y, values[idx + 1].z);
+            glm::quat q = glm::slerp(q0, q1, s);
+            return glm::vec4(q.x, q.y, q.z, q.w);
+        }
+        return glm::mix(values[idx], values[idx + 1], s);
+    case AnimInterpolation::CubicSpline: {
+        // Hermite spline from the glTF spec, tangents are scaled by the key interval
+        float s2 = s * s, s3 = s2 * s;
+        const glm::vec4& p0 = values[idx * 3 + 1];
+        const glm::vec4& m0 = values[idx * 3 + 2];
+        const glm::vec4& m1 = values[(idx + 1) * 3];
+        const glm::vec4& p1 = values[(idx + 1) * 3 + 1];
+        glm::vec4 v = (2.0f * s3 - 3.0f * s2 + 1.0f) * p0
+                    + (s3 - 2.0f * s2 + s) * dt * m0
+                    + (-2.0f * s3 + 3.0f * s2) * p1
+                    + (s3 - s2) * dt * m1;
+        return track.path == AnimPath::Rotation ? glm::normalize(v) : v;
+    }
+    }
+    return values[idx];
+}
+
+// cursors holds one entry per track, owned by the playing instance. When
+// activeJoints is set, tracks of joints it marks 0 are skipped (LOD).
+static void sampleClip(const AnimClip& clip, float time, PoseSoA& pose, std::vector<uint32_t>& cursors,
+                       const uint8_t* activeJoints = nullptr) {
+    if (cursors.size() != clip.tracks.size()) cursors.assign(clip.tracks.size(), 0);
+    for (size_t i = 0; i < clip.tracks.size(); i++) {
+        const AnimTrack& track = clip.tracks[i];
+        if (activeJoints && !activeJoints[track.joint]) continue;
+        glm::vec4 v = sampleTrack(clip, track, time, cursors[i]);
+        switch (track.path) {
+        case AnimPath::Translation: pose.setTranslation(track.joint, v.x, v.y, v.z); break;
+        case AnimPath::Rotation:    pose.setRotation(track.joint, v.x, v.y, v.z, v.w); break;
+        case AnimPath::Scale:       pose.setScale(track.joint, v.x, v.y, v.z); break;
+        }
+    }
+}
+
+// Re-bakes linear and cubic tracks as evenly spaced linear keys so sampling
+// never has to search. Trades memory for speed on long, sparse clips.
+static AnimClip resampleClip(const AnimClip& source, float rate) {
+    AnimClip clip;
+    clip.name = source.name;
+    clip.duration = source.duration;
+    clip.tracks.reserve(source.tracks.size());
+
+    for (const AnimTrack& track : source.tracks) {
+        const float* times = &source.times[track.firstKey];
+        AnimTrack baked = track;
+        baked.firstKey = (uint32_t)clip.times.size();
+        baked.firstValue = (uint32_t)clip.values.size();
+
+        float start = times[0];
+        float span = times[track.keyCount - 1] - start;
+        uint32_t keys = track.keyCount < 2 || span <= 0.0f ? 1 : (uint32_t)std::ceil(span * rate) + 1;
+        if (track.interpolation == AnimInterpolation::Step) {
+            // stepping can't be resampled without moving the steps, keep the source keys
+            baked.keyCount = track.keyCount;
+            clip.times.insert(clip.times.end(), times, times + track.keyCount);
+            clip.values.insert(clip.values.end(), source.values.begin() + track.firstValue,
+                               source.values.begin() + track.firstValue + track.keyCount);
+            clip.tracks.push_back(baked);
+            continue;
+        }
+
+        baked.keyCount = keys;
+        baked.interpolation = AnimInterpolation::Linear;
+        uint32_t cursor = 0;
+        for (uint32_t k = 0; k < keys; k++) {
+            float t = start + (float)k / rate;
+            clip.times.push_back(t);
+            clip.values.push_back(sampleTrack(source, track, t, cursor));
+        }
+        clip.tracks.push_back(baked);
+    }
+    return clip;
+}
+
+// Flags tracks whose keys are evenly spaced so findKey can index them directly
+static void markUniform(const AnimClip& clip, AnimTrack& track) {
+    track.invInterval = 0.0f;
+    if (track.keyCount < 3) return;
+
+    const float* times = &clip.times[track.firstKey];
+    float interval = (times[track.keyCount - 1] - times[0]) / (float)(track.keyCount - 1);
+    if (interval <= 0.0f) return;
+    for (uint32_t k = 1; k < track.keyCount - 1; k++) {
+        if (std::abs(times[k] - (times[0] + interval * (float)k)) > interval * 0.01f) return;
+    }
+    track.invInterval = 1.0f / interval;
+}
+
+// Resolves the glTF strings once and packs every valid channel into flat
+// arrays, ordered by joint so sampling walks the pose front to back.
+static AnimClip compileClip(const SkinAnimation& anim, int jointCount, float resampleRate) {
+    AnimClip clip;
+    clip.name = anim.name;
+    clip.duration = anim.duration;
+
+    struct PendingTrack {
+        AnimTrack track;
+        const AnimSampler* sampler;
+    };
+    std::vector<PendingTrack> pending;
+
+    for (const auto& channel : anim.channels) {
+        if (channel.jointIndex < 0 || channel.jointIndex >= jointCount) continue;
+        if (channel.samplerIndex < 0 || channel.samplerIndex >= (int)anim.samplers.size()) continue;
+        const AnimSampler& sampler = anim.samplers[channel.samplerIndex];
+        if (sampler.times.empty()) continue;
+
+        AnimTrack track{};
+        track.joint = (uint16_t)channel.jointIndex;
+        if      (channel.path == "translation") track.path = AnimPath::Translation;
+        else if (channel.path == "rotation")    track.path = AnimPath::Rotation;
+        else if (channel.path == "scale")       track.path = AnimPath::Scale;
+        else continue; // morph target weights are not supported
+
+        if      (sampler.interpolation == "STEP")        track.interpolation = AnimInterpolation::Step;
+        else if (sampler.interpolation == "CUBICSPLINE") track.interpolation = AnimInterpolation::CubicSpline;
+        else                                             track.interpolation = AnimInterpolation::Linear;
+
+        size_t valuesPerKey = track.interpolation == AnimInterpolation::CubicSpline ? 3 : 1;
+        if (sampler.values.size() < sampler.times.size() * valuesPerKey) continue;
+
+        track.keyCount = (uint32_t)sampler.times.size();
+        pending.push_back({track, &sampler});
+    }
+
+    std::stable_sort(pending.begin(), pending.end(), [](const PendingTrack& a, const PendingTrack& b) {
+        return a.track.joint != b.track.joint ? a.track.joint < b.track.joint : a.track.path < b.track.path;
+    });
+
+    clip.tracks.reserve(pending.size());
+    for (auto& p : pending) {
+        size_t valueCount = p.track.keyCount * (p.track.interpolation == AnimInterpolation::CubicSpline ? 3 : 1);
+        p.track.firstKey = (uint32_t)clip.times.size();
+        p.track.firstValue = (uint32_t)clip.values.size();
+        clip.times.insert(clip.times.end(), p.sampler->times.begin(), p.sampler->times.end());
+        clip.values.insert(clip.values.end(), p.sampler->values.begin(), p.sampler->values.begin() + valueCount);
+        clip.tracks.push_back(p.track);
+    }
+
+    if (resampleRate > 0.0f) clip = resampleClip(clip, resampleRate);
+    for (AnimTrack& track : clip.tracks) markUniform(clip, track);
+    return clip;
+}
+
 // ---- Main loader ----------------------------------------------------------
 
-void SkinnedMesh3D::loadSkinnedModel(const char* filename) {
+void SkinnedMesh3D::loadSkinnedModel(const char* filename, SharedSkinnedGeometry& geom) {
     tinygltf::Model model;
     tinygltf::TinyGLTF loader;
     std::string err, warn;
@@ -176,25 +331,25 @@ void SkinnedMesh3D::loadSkinnedModel(const char* filename) {
     std::unordered_map<int, int> nodeToJoint; // glTF node index -> joint index
 
     if (!model.skins.empty()) {
-        hasSkin = true;
+        geom.hasSkin = true;
         const tinygltf::Skin& skin = model.skins[0];
 
-        joints.resize(skin.joints.size());
+        geom.joints.resize(skin.joints.size());
         for (int j = 0; j < (int)skin.joints.size(); j++) {
-            joints[j].nodeIndex = skin.joints[j];
-            joints[j].parentJoint = -1;
+            geom.joints[j].nodeIndex = skin.joints[j];
+            geom.joints[j].parentJoint = -1;
             nodeToJoint[skin.joints[j]] = j;
 
             // Rest pose from node TRS
             const tinygltf::Node& node = model.nodes[skin.joints[j]];
-            joints[j].name = node.name;
+            geom.joints[j].name = node.name;
             if (node.translation.size() == 3)
-                joints[j].localPos = {(float)node.translation[0], (float)node.translation[1], (float)node.translation[2]};
+                geom.joints[j].restPos = {(float)node.translation[0], (float)node.translation[1], (float)node.translation[2]};
             if (node.rotation.size() == 4)
-                joints[j].localRot = glm::quat((float)node.rotation[3], (float)node.rotation[0],
+                geom.joints[j].restRot = glm::quat((float)node.rotation[3], (float)node.rotation[0],
                                                (float)node.rotation[1], (float)node.rotation[2]);
             if (node.scale.size() == 3)
-                joints[j].localScale = {(float)node.scale[0], (float)node.scale[1], (float)node.scale[2]};
+                geom.joints[j].restScale = {(float)node.scale[0], (float)node.scale[1], (float)node.scale[2]};
         }
 
         // Infer parent joints from the node child lists
@@ -203,7 +358,7 @@ void SkinnedMesh3D::loadSkinnedModel(const char* filename) {
             for (int childIdx : model.nodes[nodeIdx].children) {
                 auto childIt = nodeToJoint.find(childIdx);
                 if (childIt != nodeToJoint.end() && parentIt != nodeToJoint.end()) {
-                    joints[childIt->second].parentJoint = parentIt->second;
+                    geom.joints[childIt->second].parentJoint = parentIt->second;
                 }
             }
         }
@@ -215,13 +370,13 @@ void SkinnedMesh3D::loadSkinnedModel(const char* filename) {
             const tinygltf::BufferView& bv  = model.bufferViews[acc.bufferView];
             const tinygltf::Buffer&     buf = model.buffers[bv.buffer];
             const float* ibmData = reinterpret_cast<const float*>(&buf.data[bv.byteOffset + acc.byteOffset]);
-            for (int j = 0; j < (int)joints.size() && j < (int)acc.count; j++)
-                memcpy(&joints[j].inverseBindMatrix, ibmData + j * 16, sizeof(glm::mat4));
+            for (int j = 0; j < (int)geom.joints.size() && j < (int)acc.count; j++) {
+                glm::mat4 ibm;
+                memcpy(&ibm, ibmData + j * 16, sizeof(glm::mat4));
+                geom.joints[j].inverseBind = PoseMath::fromMat4(ibm);
+            }
         }
 
-        // Initialise bone matrices to identity
-        boneMatrices.assign(joints.size(), glm::mat4(1.0f));
-        computeJointMatrices(); // compute rest pose
     }
 
     // --- Load animations ---------------------------------------------------
@@ -271,7 +426,7 @@ void SkinnedMesh3D::loadSkinnedModel(const char* filename) {
             sa.channels.push_back(ac);
         }
 
-        animations.push_back(std::move(sa));
+        geom.animations.push_back(compileClip(sa, (int)geom.joints.size(), ANIM_RESAMPLE_RATE));
     }
 
     // --- Load geometry (with JOINTS_0 / WEIGHTS_0) -------------------------
@@ -283,16 +438,41 @@ void SkinnedMesh3D::loadSkinnedModel(const char* filename) {
 
     glm::vec3 minV(99999.0f), maxV(-99999.0f);
 
+    // Small base colour textures (eyes, face maps...) share one atlas slot
+    std::unordered_map<int, AtlasRegion> atlas = TextureAtlas::packModel(model, filename);
+
+    // Decode the rest of the model's textures in parallel before walking the primitives
+    std::vector<TextureLoadRequest> textureRequests;
+    for (const auto& mesh : model.meshes) {
+        for (const auto& prim : mesh.primitives) {
+            if (prim.material < 0 || prim.material >= (int)model.materials.size()) continue;
+            const auto& mat = model.materials[prim.material];
+            int colorIndex = mat.pbrMetallicRoughness.baseColorTexture.index;
+            if (!hasImage(model, colorIndex) || !atlas.count(model.textures[colorIndex].source))
+                queueTexture(model, colorIndex, "", VK_FORMAT_R8G8B8A8_SRGB, textureRequests);
+            queueTexture(model, mat.normalTexture.index, "_n", VK_FORMAT_R8G8B8A8_SRGB, textureRequests);
+            queueTexture(model, mat.pbrMetallicRoughness.metallicRoughnessTexture.index, "_mr", VK_FORMAT_R8G8B8A8_UNORM, textureRequests);
+        }
+    }
+    Assets::loadTextures(textureRequests);
+
     for (const auto& mesh : model.meshes) {
         for (const auto& prim : mesh.primitives) {
             if (prim.attributes.find("POSITION") == prim.attributes.end()) continue;
 
             // Resolve material / textures
             int textureID = 0, normalID = -1, mrID = -1;
+            const AtlasRegion* region = nullptr;
             if (prim.material >= 0 && prim.material < (int)model.materials.size()) {
                 const auto& mat = model.materials[prim.material];
-                textureID = loadOrGetTexture(model,
-                    mat.pbrMetallicRoughness.baseColorTexture.index, "", VK_FORMAT_R8G8B8A8_SRGB);
+                int colorIndex = mat.pbrMetallicRoughness.baseColorTexture.index;
+                auto atlasIt = (colorIndex >= 0) ? atlas.find(model.textures[colorIndex].source) : atlas.end();
+                if (atlasIt != atlas.end()) {
+                    region = &atlasIt->second;
+                    textureID = region->textureID;
+                } else {
+                    textureID = loadOrGetTexture(model, colorIndex, "", VK_FORMAT_R8G8B8A8_SRGB);
+                }
                 normalID  = loadOrGetTexture(model,
                     mat.normalTexture.index, "_n", VK_FORMAT_R8G8B8A8_SRGB);
                 mrID      = loadOrGetTexture(model,
@@ -363,8 +543,8 @@ void SkinnedMesh3D::loadSkinnedModel(const char* filename) {
 
             // Build vertices
             size_t vertCount = posAcc.count;
-            size_t baseIndex = m_skinnedVertices.size();
-            m_skinnedVertices.reserve(m_skinnedVertices.size() + vertCount);
+            size_t baseIndex = geom.vertices.size();
+            geom.vertices.reserve(geom.vertices.size() + vertCount);
 
             for (size_t v = 0; v < vertCount; v++) {
                 SkinnedVertex sv{};
@@ -373,9 +553,10 @@ void SkinnedMesh3D::loadSkinnedModel(const char* filename) {
                 sv.pos = glm::vec3(rootMat * glm::vec4(sv.pos, 1.0f));
 
                 minV = glm::min(minV, sv.pos); maxV = glm::max(maxV, sv.pos);
-                modelCenter += sv.pos;
+                geom.modelCenter += sv.pos;
 
                 if (texData)    { sv.texCoord = {texData[v*texStride], texData[v*texStride+1]}; }
+                if (region)       sv.texCoord = region->remap(sv.texCoord);
                 if (normalData) { sv.normal = glm::vec3(normalData[v*normalStride], normalData[v*normalStride+1], normalData[v*normalStride+2]);
                                   sv.normal = glm::mat3(rootMat) * sv.normal; }
                 else              sv.normal = {0.0f, 1.0f, 0.0f};
@@ -413,7 +594,7 @@ void SkinnedMesh3D::loadSkinnedModel(const char* filename) {
                     if (idx < 0 || idx >= MAX_BONES) idx = 0;
                 }
 
-                m_skinnedVertices.push_back(sv);
+                geom.vertices.push_back(sv);
             }
 
             // Indices
@@ -429,15 +610,15 @@ void SkinnedMesh3D::loadSkinnedModel(const char* filename) {
                         idx = reinterpret_cast<const uint16_t*>(idxRaw)[i];
                     else
                         idx = idxRaw[i];
-                    m_indices.push_back((uint32_t)(baseIndex + idx));
+                    geom.indices.push_back((uint32_t)(baseIndex + idx));
                 }
             }
         }
     }
 
-    if (!m_skinnedVertices.empty()) {
-        AA = minV; BB = maxV;
-        modelCenter /= (float)m_skinnedVertices.size();
+    if (!geom.vertices.empty()) {
+        geom.AA = minV; geom.BB = maxV;
+        geom.modelCenter /= (float)geom.vertices.size();
     }
 }
 
@@ -447,116 +628,230 @@ std::unordered_map<std::string, SharedSkinnedGeometry*> SkinnedMesh3D::s_cache;
 
 // ---- Public interface ----------------------------------------------------
 
-void SkinnedMesh3D::init(const char* filename) {
-    fileName = filename;
-
+SharedSkinnedGeometry* SkinnedMesh3D::acquireGeometry(const char* filename) {
     auto it = s_cache.find(filename);
     if (it != s_cache.end()) {
-        // Cache hit: reuse parsed skeleton, animations, and GPU geometry buffers.
-        skinnedSharedGeom = it->second;
-        skinnedSharedGeom->refCount++;
-
-        // Copy bind-pose joint hierarchy as the working state for this instance.
-        joints     = skinnedSharedGeom->joints;
-        animations = skinnedSharedGeom->animations;
-        hasSkin    = skinnedSharedGeom->hasSkin;
-        testBoneIndex = skinnedSharedGeom->testBoneIndex;
-        AA = skinnedSharedGeom->AA; BB = skinnedSharedGeom->BB; modelCenter = skinnedSharedGeom->modelCenter;
-        // Index count is needed by draw() — copy the index vector (uint32 only, cheap)
-        m_indices = skinnedSharedGeom->indices;
-
-        // Reference shared GPU vertex/index buffers (not owned by this instance).
-        vertexBuffer       = skinnedSharedGeom->vertexBuffer;
-        vertexBufferMemory = skinnedSharedGeom->vertexBufferMemory;
-        indexBuffer        = skinnedSharedGeom->indexBuffer;
-        indexBufferMemory  = skinnedSharedGeom->indexBufferMemory;
-    } else {
-        // Cache miss: parse from disk, upload geometry, populate cache.
-        skinnedSharedGeom = new SharedSkinnedGeometry();
-        skinnedSharedGeom->refCount = 1;
-
-        loadSkinnedModel(filename);   // fills m_skinnedVertices, m_indices, joints, animations, hasSkin, AA/BB
-
-        createVertexBuffer();
-        createIndexBuffer();
-
-        // Pick test bone (same result for every instance of this model).
-        if (hasSkin && !joints.empty()) {
-            auto nameContains = [&](int ji, const char* substr) {
-                std::string lower(joints[ji].name.size(), '\0');
-                std::transform(joints[ji].name.begin(), joints[ji].name.end(), lower.begin(), ::tolower);
-                return lower.find(substr) != std::string::npos;
-            };
-            testBoneIndex = 0;
-            for (int j = 0; j < (int)joints.size(); j++) {
-                if (nameContains(j, "spine") &&
-                    !nameContains(j, "ik") &&
-                    !nameContains(j, "pole") &&
-                    !nameContains(j, "target") &&
-                    !nameContains(j, "ctrl")) {
-                    testBoneIndex = j;
-                    break;
-                }
+        // Cache hit: the skeleton, clips and GPU buffers are shared as-is.
+        it->second->refCount++;
+        return it->second;
+    }
+
+    // Cache miss: parse from disk, upload geometry, populate cache.
+    SharedSkinnedGeometry* geom = new SharedSkinnedGeometry();
+    geom->path = filename;
+    geom->refCount = 1;
+
+    loadSkinnedModel(filename, *geom);
+
+    // vertices go to the skinning source pool, only skinning.comp reads them
+    if (!SkinningPass::sourcePool.allocate((uint32_t)geom->vertices.size(), geom->sourceRange)) {
+        delete geom;
+        return nullptr;
+    }
+    SkinningPass::uploadSource(geom->sourceRange, geom->vertices.data());
+    createIndexBuffer(*geom);
+    geom->materialFeatures = ShaderVariants::featuresFromVertices(geom->vertices);
+
+    // Pick test bone (same result for every instance of this model).
+    const std::vector<Joint>& skeleton = geom->joints;
+    if (geom->hasSkin && !skeleton.empty()) {
+        auto nameContains = [&](int ji, const char* substr) {
+            std::string lower(skeleton[ji].name.size(), '\0');
+            std::transform(skeleton[ji].name.begin(), skeleton[ji].name.end(), lower.begin(), ::tolower);
+            return lower.find(substr) != std::string::npos;
+        };
+        geom->testBoneIndex = 0;
+        for (int j = 0; j < (int)skeleton.size(); j++) {
+            if (nameContains(j, "spine") &&
+                !nameContains(j, "ik") &&
+                !nameContains(j, "pole") &&
+                !nameContains(j, "target") &&
+                !nameContains(j, "ctrl")) {
+                geom->testBoneIndex = j;
+                break;
             }
         }
+    }
+
+    computeLODJoints(*geom);
+
+    // Rest pose in SoA form: the starting pose and the additive reference
+    geom->restPose.resize(skeleton.size());
+    for (size_t j = 0; j < skeleton.size(); j++) {
+        geom->restPose.setTranslation(j, skeleton[j].restPos);
+        geom->restPose.setRotation(j, skeleton[j].restRot);
+        geom->restPose.setScale(j, skeleton[j].restScale);
+    }
+
+    s_cache[filename] = geom;
+    return geom;
+}
+
+void SkinnedMesh3D::releaseGeometry(SharedSkinnedGeometry* geom) {
+    if (--geom->refCount > 0) return;
 
-        // Stash everything in the cache.
-        skinnedSharedGeom->joints      = joints;
-        skinnedSharedGeom->animations  = animations;
-        skinnedSharedGeom->hasSkin     = hasSkin;
-        skinnedSharedGeom->testBoneIndex = testBoneIndex;
-        skinnedSharedGeom->AA = AA; skinnedSharedGeom->BB = BB; skinnedSharedGeom->modelCenter = modelCenter;
-        skinnedSharedGeom->vertexBuffer       = vertexBuffer;
-        skinnedSharedGeom->vertexBufferMemory = vertexBufferMemory;
-        skinnedSharedGeom->indexBuffer        = indexBuffer;
-        skinnedSharedGeom->indexBufferMemory  = indexBufferMemory;
-        skinnedSharedGeom->indices            = m_indices;
-        s_cache[filename] = skinnedSharedGeom;
+    // Last user — release shared GPU buffers.
+    SkinningPass::sourcePool.release(geom->sourceRange);
+    vkDestroyBuffer(VK::device, geom->indexBuffer, nullptr);
+    vkFreeMemory(VK::device, geom->indexBufferMemory, nullptr);
+    for (auto& [clip, baked] : geom->bakedClips) {
+        vkDestroyBuffer(VK::device, baked.buffer, nullptr);
+        vkFreeMemory(VK::device, baked.memory, nullptr);
     }
+    s_cache.erase(geom->path);
+    delete geom;
+}
+
+bool SkinnedMesh3D::init(const char* filename) {
+    fileName = filename;
+    skinnedSharedGeom = acquireGeometry(filename);
+    if (!skinnedSharedGeom) return false;
+
+    // Reference the shared GPU index buffer (not owned by this instance).
+    indexBuffer        = skinnedSharedGeom->indexBuffer;
+    indexBufferMemory  = skinnedSharedGeom->indexBufferMemory;
+    materialFeatures   = skinnedSharedGeom->materialFeatures;
+    AA = skinnedSharedGeom->AA; BB = skinnedSharedGeom->BB; modelCenter = skinnedSharedGeom->modelCenter;
+
+    // Per-instance pose starts at the rest pose: O(joints), no keyframe data copied
+    pose = skinnedSharedGeom->restPose;
+    blendFrom = pose;
+    blendTo = pose;
+    for (AnimLayer& layer : layers) {
+        layer.shown = pose;
+        layer.snapshot = pose;
+    }
+    worldTransforms.resize(pose.padded());
+
+    // Reserve cursors for the largest clip so switching clips never allocates
+    size_t maxTracks = 0;
+    for (const AnimClip& clip : animations()) maxTracks = std::max(maxTracks, clip.tracks.size());
+    for (AnimLayer& layer : layers) {
+        layer.current.cursors.reserve(maxTracks);
+        layer.previous.cursors.reserve(maxTracks);
+    }
+    // the base layer plays the first clip unless told otherwise
+    if (!animations().empty()) layers[0].current.clip = 0;
 
     testBonePhase = (float)(rand() % 628) / 100.0f;
-    boneMatrices.resize(joints.size(), glm::mat4(1.0f));
+    animPhase = (uint32_t)rand();
     updateModelMatrix();
-    createBoneBuffers();
+
+    // Ranges in the shared skinning pools; the palette is sized to the rig
+    // (at least one matrix, which unskinned vertices point at)
+    if (!SkinningPass::outputPool.allocate((uint32_t)skinnedSharedGeom->vertices.size(), outputRange) ||
+        !SkinningPass::bonePool.allocate((uint32_t)std::clamp((int)joints().size(), 1, MAX_BONES), boneRange)) {
+        destroy(); // gives back whatever was taken
+        return false;
+    }
+
+    writeRestPalette();
+    return true;
 }
 
-void SkinnedMesh3D::destroy() {
-    if (skinnedSharedGeom) {
-        skinnedSharedGeom->refCount--;
-        if (skinnedSharedGeom->refCount <= 0) {
-            // Last instance — release shared GPU buffers.
-            vkDestroyBuffer(VK::device, skinnedSharedGeom->vertexBuffer, nullptr);
-            vkFreeMemory(VK::device, skinnedSharedGeom->vertexBufferMemory, nullptr);
-            vkDestroyBuffer(VK::device, skinnedSharedGeom->indexBuffer, nullptr);
-            vkFreeMemory(VK::device, skinnedSharedGeom->indexBufferMemory, nullptr);
-            s_cache.erase(fileName);
-            delete skinnedSharedGeom;
-            skinnedSharedGeom = nullptr;
+// Rest-pose palette in every frame so instances that never animate still skin correctly
+void SkinnedMesh3D::writeRestPalette() {
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        Affine3x4* palette = SkinningPass::palette(i, boneRange);
+        std::fill(palette, palette + boneRange.count, PoseMath::identity());
+        if (skinnedSharedGeom->hasSkin) computeJointMatrices(palette, false);
+    }
+    unskinnedFrames = (1u << MAX_FRAMES_IN_FLIGHT) - 1;
+}
+
+void SkinnedMesh3D::reset() {
+    destroyRigidBody();
+    character.reset();
+    activationPolicy = ACTIVATION_AUTO;
+
+    position = glm::vec3(0.0f);
+    scale = glm::vec3(1.0f);
+    orientation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    visible = true;
+
+    // same capacity as before, so nothing here allocates
+    pose = skinnedSharedGeom->restPose;
+    for (AnimLayer& layer : layers) {
+        layer.current.clip = -1;
+        layer.current.time = 0.0f;
+        layer.current.cursors.clear();
+        layer.previous.clip = -1;
+        layer.previous.time = 0.0f;
+        layer.previous.cursors.clear();
+        layer.fadeElapsed = 0.0f;
+        layer.fadeDuration = 0.0f;
+        layer.weight = 1.0f;
+        layer.looping = true;
+        layer.additive = false;
+        layer.mask.clear();
+        layer.shownValid = false;
+        layer.fromSnapshot = false;
+    }
+    if (!animations().empty()) layers[0].current.clip = 0;
+    animSpeed = 1.0f;
+    animLOD = 0;
+    onScreen = false;
+    staleFrames = 0;
+
+    updateModelMatrix();
+    writeRestPalette();
+}
+
+// Joints that carry almost no skin weight (fingers, face, twist helpers) are
+// dropped at far LODs. Ancestors of kept joints are always kept, so every
+// dropped joint has a kept ancestor to follow.
+void SkinnedMesh3D::computeLODJoints(SharedSkinnedGeometry& geom) {
+    const std::vector<Joint>& skeleton = geom.joints;
+    int count = (int)skeleton.size();
+    if (count == 0 || geom.vertices.empty()) return;
+
+    std::vector<float> influence(count, 0.0f);
+    for (const SkinnedVertex& v : geom.vertices) {
+        for (int k = 0; k < 4; k++) {
+            int j = v.jointIndices[k];
+            if (j >= 0 && j < count) influence[j] += v.jointWeights[k];
         }
-        // Don't free instance handles — they point into the shared geometry.
-    } else {
-        vkDestroyBuffer(VK::device, indexBuffer, nullptr);
-        vkFreeMemory(VK::device, indexBufferMemory, nullptr);
-        vkDestroyBuffer(VK::device, vertexBuffer, nullptr);
-        vkFreeMemory(VK::device, vertexBufferMemory, nullptr);
     }
 
-    // Per-instance bone SSBOs and descriptor pool are always owned by this instance.
-    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        vkDestroyBuffer(VK::device, boneBuffers[i], nullptr);
-        vkFreeMemory(VK::device, boneBufferMemories[i], nullptr);
+    float threshold = ANIM_LOD_MIN_JOINT_INFLUENCE * (float)geom.vertices.size();
+    geom.lodJointKept.assign((count + 3) & ~3, 0);
+    for (int j = count - 1; j >= 0; j--) {
+        if (influence[j] >= threshold || skeleton[j].parentJoint < 0) geom.lodJointKept[j] = 1;
+        int parent = skeleton[j].parentJoint;
+        if (geom.lodJointKept[j] && parent >= 0) geom.lodJointKept[parent] = 1;
     }
-    if (boneDescriptorPool != VK_NULL_HANDLE) {
-        vkDestroyDescriptorPool(VK::device, boneDescriptorPool, nullptr);
-        boneDescriptorPool = VK_NULL_HANDLE;
+
+    geom.lodJointTarget.resize(count);
+    int kept = 0;
+    for (int j = 0; j < count; j++) {
+        int parent = skeleton[j].parentJoint;
+        geom.lodJointTarget[j] = geom.lodJointKept[j] ? j : geom.lodJointTarget[parent];
+        kept += geom.lodJointKept[j];
     }
+    Logger::info("SkinnedMesh3D", ("Animation LOD keeps " + std::to_string(kept) + "/" + std::to_string(count) + " joints").c_str());
+}
+
+void SkinnedMesh3D::destroy() {
+    destroyRigidBody();
+    character.reset();
+
+    // Don't free instance handles — they point into the shared geometry.
+    if (skinnedSharedGeom) {
+        releaseGeometry(skinnedSharedGeom);
+        skinnedSharedGeom = nullptr;
+    }
+
+    // Palette and output ranges are always owned by this instance.
+    SkinningPass::bonePool.release(boneRange);
+    SkinningPass::outputPool.release(outputRange);
+    boneRange = {0, 0};
+    outputRange = {0, 0};
 }
 
 void SkinnedMesh3D::createCapsuleRigidBody(float mass, float radius, float height) {
     hasPhysics = true;
 
-    btCollisionShape* shape = new btCapsuleShape(radius, height);
-    shape->setMargin(0.001f);
+    btCollisionShape* shape = ShapeCache::capsule(radius, height, 0.001f);
 
     // Place capsule centre at the mesh position
     btTransform t;
@@ -566,104 +861,389 @@ void SkinnedMesh3D::createCapsuleRigidBody(float mass, float radius, float heigh
     btVector3 inertia(0, 0, 0);
     if (mass > 0.0f) shape->calculateLocalInertia(mass, inertia);
 
-    btDefaultMotionState* ms = new btDefaultMotionState(t);
-    btRigidBody::btRigidBodyConstructionInfo ci(mass, ms, shape, inertia);
-    rigidBody = new btRigidBody(ci);
+    rigidBody = Physics::BodyPool::create(mass, shape, t, inertia);
     rigidBody->setAngularFactor(btVector3(0, 0, 0));
-    rigidBody->setActivationState(DISABLE_DEACTIVATION);
-}
-
-
-void SkinnedMesh3D::updateAnimation(float dt) {
-    if (!hasSkin) return;
-
-    animTime += dt * animSpeed;
-
-    if (!animations.empty()) {
-        SkinAnimation& anim = animations[currentAnimation];
-        if (anim.duration > 0.0f) {
-            if (animTime > anim.duration)
-                animTime = looping ? std::fmod(animTime, anim.duration) : anim.duration;
-
-            // Sample each animation channel
-            for (const auto& channel : anim.channels) {
-                if (channel.jointIndex < 0 || channel.jointIndex >= (int)joints.size()) continue;
-                if (channel.samplerIndex < 0 || channel.samplerIndex >= (int)anim.samplers.size()) continue;
-                const AnimSampler& sampler = anim.samplers[channel.samplerIndex];
-                if (sampler.times.size() < 2) continue;
-
-                float t = glm::clamp(animTime, sampler.times.front(), sampler.times.back());
-
-                int idx = (int)(std::lower_bound(sampler.times.begin(), sampler.times.end(), t)
-                                - sampler.times.begin()) - 1;
-                idx = glm::clamp(idx, 0, (int)sampler.times.size() - 2);
-
-                float t0 = sampler.times[idx];
-                float t1 = sampler.times[idx + 1];
-                float blend = (t1 > t0) ? (t - t0) / (t1 - t0) : 0.0f;
-                blend = glm::clamp(blend, 0.0f, 1.0f);
-
-                // For CUBICSPLINE each keyframe has 3 output values:
-                // [in-tangent, value, out-tangent]. Pick the value (offset 1).
-                bool cubic = (sampler.interpolation == "CUBICSPLINE");
-                int stride = cubic ? 3 : 1;
-                int vi  = idx  * stride + (cubic ? 1 : 0);
-                int vi1 = (idx + 1) * stride + (cubic ? 1 : 0);
-                if (vi >= (int)sampler.values.size() || vi1 >= (int)sampler.values.size()) continue;
-
-                Joint& joint = joints[channel.jointIndex];
-
-                if (channel.path == "translation") {
-                    joint.localPos = glm::mix(glm::vec3(sampler.values[vi]),
-                                              glm::vec3(sampler.values[vi1]), blend);
-                } else if (channel.path == "rotation") {
-                    glm::quat q0(sampler.values[vi].w,  sampler.values[vi].x,
-                                 sampler.values[vi].y,  sampler.values[vi].z);
-                    glm::quat q1(sampler.values[vi1].w, sampler.values[vi1].x,
-                                 sampler.values[vi1].y, sampler.values[vi1].z);
-                    joint.localRot = glm::slerp(q0, q1, blend);
-                } else if (channel.path == "scale") {
-                    joint.localScale = glm::mix(glm::vec3(sampler.values[vi]),
-                                                glm::vec3(sampler.values[vi1]), blend);
+    rigidBody->setSleepingThresholds(PHYSICS_SLEEP_LINEAR, PHYSICS_SLEEP_ANGULAR);
+    Physics::applyActivationPolicy(rigidBody, activationPolicy);
+}
+
+void SkinnedMesh3D::createCharacterController(float radius, float height, float stepHeight, float maxSlopeDegrees) {
+    Physics::CharacterSettings settings;
+    settings.radius = radius;
+    settings.height = height;
+    settings.stepHeight = stepHeight;
+    settings.maxSlope = glm::radians(maxSlopeDegrees);
+
+    character = std::make_shared<Physics::CharacterController>(settings, worldToPhysics(position));
+    rigidBody = character->body;
+    hasPhysics = true;
+}
+
+void SkinnedMesh3D::setWalkVelocity(glm::vec3 velocity) {
+    if (character) character->setWalkVelocity(worldToPhysics(velocity));
+}
+
+void SkinnedMesh3D::jump(float speed) {
+    if (character) character->jump(speed);
+}
+
+void SkinnedMesh3D::teleport(glm::vec3 target) {
+    if (character) character->teleport(worldToPhysics(target));
+}
+
+bool SkinnedMesh3D::isGrounded() const {
+    if (!character) return false;
+    const Physics::BodyState* state = Physics::state(rigidBody);
+    return state && state->grounded;
+}
+
+
+static void advancePlayback(AnimPlayback& playback, const std::vector<AnimClip>& clips, float dt, bool looping) {
+    if (playback.clip < 0) return;
+    float duration = clips[playback.clip].duration;
+    playback.time += dt;
+    if (duration > 0.0f && playback.time > duration)
+        playback.time = looping ? std::fmod(playback.time, duration) : duration;
+}
+
+void SkinnedMesh3D::advanceAnimation(float dt) {
+    if (!hasSkin()) return;
+
+    float step = dt * animSpeed;
+    const std::vector<AnimClip>& clips = animations();
+    if (clips.empty()) {
+        layers[0].current.time += step;   // drives the test bone
+        return;
+    }
+
+    for (AnimLayer& layer : layers) {
+        if (layer.fadeDuration > 0.0f) {
+            layer.fadeElapsed += step;
+            if (layer.fadeElapsed >= layer.fadeDuration) {
+                layer.fadeDuration = 0.0f;
+                layer.previous.clip = -1;
+                layer.shownValid = false;
+                layer.fromSnapshot = false;
+            }
+        }
+        advancePlayback(layer.current, clips, step, layer.looping);
+        advancePlayback(layer.previous, clips, step, layer.looping);
+    }
+}
+
+void SkinnedMesh3D::evaluateAnimation(int frameIndex) {
+    if (!hasSkin()) return;
+
+    const std::vector<AnimClip>& clips = animations();
+    const PoseSoA& rest = skinnedSharedGeom->restPose;
+    bool reduced = animLOD >= ANIM_LOD_REDUCED_JOINTS && !skinnedSharedGeom->lodJointKept.empty();
+    const uint8_t* activeJoints = reduced ? skinnedSharedGeom->lodJointKept.data() : nullptr;
+
+    if (clips.empty()) {
+        // Test bone rotation only when there is no real animation data
+        int testBoneIndex = skinnedSharedGeom->testBoneIndex;
+        if (testBoneIndex >= 0 && testBoneIndex < (int)pose.count) {
+            float angle = std::sin(layers[0].current.time * 1.5f + testBonePhase) * glm::radians(5.0f);
+            pose.setRotation(testBoneIndex, glm::angleAxis(angle, glm::vec3(0.0f, 1.0f, 0.0f)));
+        }
+    } else {
+        pose.copyFrom(rest);
+
+        for (AnimLayer& layer : layers) {
+            bool hasTo = layer.current.clip >= 0;
+            bool hasFrom = layer.previous.clip >= 0 || layer.fromSnapshot;
+            if ((!hasTo && !hasFrom) || layer.weight <= 0.0f) continue;
+
+            float fade = layer.fadeDuration > 0.0f ? layer.fadeElapsed / layer.fadeDuration : 1.0f;
+            const float* mask = layer.mask.empty() ? nullptr : layer.mask.data();
+
+            // Common case: one full-weight clip replacing the pose, sampled in place
+            if (hasTo && !hasFrom && fade >= 1.0f && layer.weight >= 1.0f && !mask && !layer.additive) {
+                sampleClip(clips[layer.current.clip], layer.current.time, pose, layer.current.cursors, activeJoints);
+                continue;
+            }
+
+            // Joints a clip has no track for keep the pose below (or the rest pose
+            // for additive layers, i.e. no delta)
+            const PoseSoA& below = layer.additive ? rest : pose;
+            float weight = layer.weight;
+            const PoseSoA* sampled = &blendTo;
+            if (hasTo) {
+                blendTo.copyFrom(below);
+                sampleClip(clips[layer.current.clip], layer.current.time, blendTo, layer.current.cursors, activeJoints);
+            }
+            if (hasFrom) {
+                float fromWeight = 1.0f;
+                if (layer.fromSnapshot) {
+                    blendFrom.copyFrom(layer.snapshot);
+                    fromWeight = layer.snapshotWeight;
+                } else {
+                    blendFrom.copyFrom(below);
+                    sampleClip(clips[layer.previous.clip], layer.previous.time, blendFrom, layer.previous.cursors, activeJoints);
+                }
+                if (hasTo) {
+                    PoseMath::blend(blendFrom, blendTo, fade, nullptr);
+                    weight *= fromWeight + (1.0f - fromWeight) * fade;
+                } else {
+                    weight *= fromWeight * (1.0f - fade);   // fading the layer out
                 }
+                sampled = &blendFrom;
+            } else {
+                weight *= fade;                // fading the layer in
+            }
+
+            if (fade < 1.0f) {
+                // where a fade interrupting this one has to start from
+                layer.shown.copyFrom(*sampled);
+                layer.shownWeight = weight / layer.weight;
+                layer.shownValid = true;
             }
+
+            if (layer.additive) PoseMath::addDelta(pose, *sampled, rest, weight, mask);
+            else                PoseMath::blend(pose, *sampled, weight, mask);
         }
     }
 
-    // Apply test bone rotation only when there is no real animation data,
-    // so we don't clobber animation-driven joints.
-    if (animations.empty() && testBoneIndex >= 0 && testBoneIndex < (int)joints.size()) {
-        float angle = std::sin(animTime * 1.5f + testBonePhase) * glm::radians(5.0f);
-        joints[testBoneIndex].localRot = glm::angleAxis(angle, glm::vec3(0.0f, 1.0f, 0.0f));
+    // The caller waited on this frame's fence, so the GPU is done with its palette
+    computeJointMatrices(SkinningPass::palette(frameIndex, boneRange), reduced);
+    staleFrames = ((1u << MAX_FRAMES_IN_FLIGHT) - 1) & ~(1u << frameIndex);
+    paletteFrame = frameIndex;
+    unskinnedFrames |= 1u << frameIndex;
+}
+
+bool SkinnedMesh3D::selectAnimLOD(const glm::vec3& cameraPos, float projScale, Frustum& frustum, uint64_t frame, int frameIndex) {
+    bool wasOnScreen = onScreen;
+
+    // bounding sphere in render space (shader scales glTF units by 0.01)
+    glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(modelCenter * 0.01f, 1.0f));
+    float maxScale = std::max({glm::length(glm::vec3(modelMatrix[0])),
+                               glm::length(glm::vec3(modelMatrix[1])),
+                               glm::length(glm::vec3(modelMatrix[2]))});
+    float radius = glm::length(BB - AA) * 0.5f * 0.01f * maxScale;
+
+    onScreen = isVisible() && frustum.IsBoxVisible(center - glm::vec3(radius), center + glm::vec3(radius));
+    if (!onScreen) return false;
+
+    // projected height as a fraction of the screen
+    float distance = std::max(glm::length(center - cameraPos), 1e-4f);
+    float screenSize = radius * projScale / distance;
+    if      (screenSize >= ANIM_LOD_SCREEN_SIZE_1) animLOD = 0;
+    else if (screenSize >= ANIM_LOD_SCREEN_SIZE_2) animLOD = 1;
+    else if (screenSize >= ANIM_LOD_SCREEN_SIZE_3) animLOD = 2;
+    else                                           animLOD = 3;
+
+    if (!wasOnScreen) return true;
+
+    // LOD n updates every 2^n frames, staggered so a horde doesn't spike one frame
+    uint64_t interval = 1ull << animLOD;
+    if (((frame + animPhase) & (interval - 1)) == 0) return true;
+
+    // This frame's buffer missed the last evaluation: bring it up to date by
+    // copying that palette over instead of posing again. The caller waited
+    // on this frame's fence, and the GPU only reads the other one.
+    if (staleFrames & (1u << frameIndex)) {
+        const Affine3x4* latest = SkinningPass::palette(paletteFrame, boneRange);
+        std::copy(latest, latest + boneRange.count, SkinningPass::palette(frameIndex, boneRange));
+        staleFrames &= ~(1u << frameIndex);
+        unskinnedFrames |= 1u << frameIndex;
+    }
+    return false;
+}
+
+void SkinnedMesh3D::playLayer(int layerIndex, int index, float fadeDuration) {
+    AnimLayer* layer = layerAt(layerIndex);
+    if (!layer || getAnimCount() == 0) return;
+
+    if (fadeDuration > 0.0f) {
+        bool fading = layer->fadeDuration > 0.0f;
+        if (fading && layer->shownValid) {
+            // fade from the blend on screen, not from either of its clips;
+            // swapping the buffers keeps this allocation free
+            std::swap(layer->snapshot, layer->shown);
+            layer->snapshotWeight = layer->shownWeight;
+            layer->previous.clip = -1;
+            layer->fromSnapshot = true;
+        } else if (!fading || layer->fadeElapsed >= layer->fadeDuration * 0.5f) {
+            // swap keeps both cursor buffers, so nothing is reallocated
+            std::swap(layer->previous, layer->current);
+            layer->fromSnapshot = false;
+        }
+        // else not evaluated since the last fade started (off screen): the
+        // side it was fading from still weighs most, keep fading from it
+        layer->fadeElapsed = 0.0f;
+        layer->fadeDuration = fadeDuration;
+        layer->shownValid = false;
+    } else {
+        layer->previous.clip = -1;
+        layer->fadeDuration = 0.0f;
+        layer->fromSnapshot = false;
     }
+    layer->current.clip = index < 0 ? -1 : std::min(index, getAnimCount() - 1);
+    layer->current.time = 0.0f;
+    layer->current.cursors.clear();
+}
+
+void SkinnedMesh3D::stopLayer(int layerIndex, float fadeDuration) {
+    playLayer(layerIndex, -1, fadeDuration);
+}
 
-    computeJointMatrices();
+void SkinnedMesh3D::setLayerWeight(int layerIndex, float weight) {
+    if (AnimLayer* layer = layerAt(layerIndex)) layer->weight = std::clamp(weight, 0.0f, 1.0f);
 }
 
-void SkinnedMesh3D::computeJointMatrices() {
-    std::vector<glm::mat4> globalTransforms(joints.size(), glm::mat4(1.0f));
-    boneMatrices.resize(joints.size());
+void SkinnedMesh3D::setLayerAdditive(int layerIndex, bool additive) {
+    if (AnimLayer* layer = layerAt(layerIndex)) layer->additive = additive;
+}
+
+void SkinnedMesh3D::setLayerLooping(int layerIndex, bool loop) {
+    if (AnimLayer* layer = layerAt(layerIndex)) layer->looping = loop;
+}
+
+bool SkinnedMesh3D::setLayerMask(int layerIndex, const std::string& jointName) {
+    AnimLayer* layer = layerAt(layerIndex);
+    int root = findJoint(jointName);
+    if (!layer || root < 0) return false;
+
+    // joints are ordered parents first, so one pass marks the whole subtree
+    const std::vector<Joint>& skeleton = joints();
+    layer->mask.assign(pose.padded(), 0.0f);
+    layer->mask[root] = 1.0f;
+    for (int j = root + 1; j < (int)skeleton.size(); j++) {
+        int parent = skeleton[j].parentJoint;
+        if (parent >= 0 && layer->mask[parent] > 0.0f) layer->mask[j] = 1.0f;
+    }
+    return true;
+}
+
+void SkinnedMesh3D::clearLayerMask(int layerIndex) {
+    if (AnimLayer* layer = layerAt(layerIndex)) layer->mask.clear();
+}
+
+int SkinnedMesh3D::findJoint(const std::string& name) const {
+    if (!skinnedSharedGeom) return -1;
+    const std::vector<Joint>& skeleton = joints();
+    for (int j = 0; j < (int)skeleton.size(); j++) {
+        if (skeleton[j].name == name) return j;
+    }
+    return -1;
+}
+
+// Writes the palette into mapped (write-combined) memory: each matrix is
+// stored once and never read back, the hierarchy walk uses worldTransforms.
+// With reduced set, joints dropped by the LOD reuse their nearest kept
+// ancestor's matrix, i.e. they stay rigid in their rest pose relative to it.
+void SkinnedMesh3D::computeJointMatrices(Affine3x4* palette, bool reduced) {
+    buildPalette(*skinnedSharedGeom, pose, worldTransforms.data(), palette, reduced);
+}
 
+void SkinnedMesh3D::buildPalette(const SharedSkinnedGeometry& geom, const PoseSoA& pose,
+                                 Affine3x4* world, Affine3x4* palette, bool reduced) {
+    const std::vector<Joint>& skeleton = geom.joints;
+    int count = std::min((int)skeleton.size(), MAX_BONES);
+    const uint8_t* kept = geom.lodJointKept.data();
+    const int* target = geom.lodJointTarget.data();
+
+    // All local transforms in one SIMD pass, then concatenated in place.
     // Joints must be in topological order (parents before children), which
     // glTF exporters virtually always guarantee.
-    for (int i = 0; i < (int)joints.size(); i++) {
-        glm::mat4 local = glm::translate(glm::mat4(1.0f), joints[i].localPos)
-                        * glm::toMat4(joints[i].localRot)
-                        * glm::scale(glm::mat4(1.0f), joints[i].localScale);
+    PoseMath::toAffine(pose, world);
+    for (int i = 0; i < count; i++) {
+        if (reduced && !kept[i]) {
+            int a = target[i];
+            PoseMath::concat(world[a], skeleton[a].inverseBind, palette[i]);
+            continue;
+        }
+        int parent = skeleton[i].parentJoint;
+        if (parent >= 0)
+            PoseMath::concat(world[parent], world[i], world[i]);
 
-        if (joints[i].parentJoint < 0)
-            globalTransforms[i] = local;
-        else
-            globalTransforms[i] = globalTransforms[joints[i].parentJoint] * local;
+        PoseMath::concat(world[i], skeleton[i].inverseBind, palette[i]);
+    }
+}
 
-        boneMatrices[i] = globalTransforms[i] * joints[i].inverseBindMatrix;
+// ---- Baked clips ----------------------------------------------------------
+
+// CPU twin of skinning.comp: same blend, same output layout
+static void skinVertex(const SkinnedVertex& src, const Affine3x4* palette, int paletteSize, Vertex& dst) {
+    Affine3x4 skin{};
+    for (int k = 0; k < 4; k++) {
+        float w = src.jointWeights[k];
+        if (w == 0.0f) continue;
+        const Affine3x4& bone = palette[std::clamp(src.jointIndices[k], 0, paletteSize - 1)];
+        for (int r = 0; r < 3; r++)
+            for (int c = 0; c < 4; c++) skin.m[r][c] += w * bone.m[r][c];
     }
+
+    auto apply = [&](const glm::vec3& v, float w) {
+        glm::vec4 p(v, w);
+        return glm::vec3(glm::dot(glm::vec4(skin.m[0][0], skin.m[0][1], skin.m[0][2], skin.m[0][3]), p),
+                         glm::dot(glm::vec4(skin.m[1][0], skin.m[1][1], skin.m[1][2], skin.m[1][3]), p),
+                         glm::dot(glm::vec4(skin.m[2][0], skin.m[2][1], skin.m[2][2], skin.m[2][3]), p));
+    };
+
+    dst.pos = apply(src.pos, 1.0f);
+    dst.normal = glm::normalize(apply(src.normal, 0.0f));
+    dst.texCoord = src.texCoord;
+    dst.textureID = src.textureID;
+    dst.normalID = src.normalID;
+    dst.metallicRoughnessID = src.metallicRoughnessID;
+    dst.tangent = glm::vec4(apply(glm::vec3(src.tangent), 0.0f), src.tangent.w);
+    dst.bitangent = apply(src.bitangent, 0.0f);
 }
 
-void SkinnedMesh3D::uploadBoneMatrices(int frameIndex) {
-    size_t count = std::min((int)boneMatrices.size(), MAX_BONES);
-    if (count > 0)
-        memcpy(boneMappedPtrs[frameIndex], boneMatrices.data(), count * sizeof(glm::mat4));
+const BakedClip& SkinnedMesh3D::bakeClip(SharedSkinnedGeometry& geom, int clipIndex) {
+    clipIndex = std::clamp(clipIndex, 0, std::max((int)geom.animations.size() - 1, 0));
+    auto it = geom.bakedClips.find(clipIndex);
+    if (it != geom.bakedClips.end()) return it->second;
+
+    const std::vector<SkinnedVertex>& source = geom.vertices;
+    size_t vertexCount = source.size();
+    const AnimClip* clip = geom.animations.empty() ? nullptr : &geom.animations[clipIndex];
+
+    BakedClip baked;
+    baked.frameRate = VAT_BAKE_RATE;
+    baked.duration = clip ? clip->duration : 0.0f;
+    baked.frameCount = std::max(1u, (uint32_t)std::ceil(baked.duration * baked.frameRate));
+
+    // Frames are independent, so each job samples and skins its own
+    std::vector<Vertex> frames(vertexCount * baked.frameCount);
+    int paletteSize = std::clamp((int)geom.joints.size(), 1, MAX_BONES);
+    Jobs::parallelFor(baked.frameCount, [&](size_t f) {
+        PoseSoA pose = geom.restPose;
+        std::vector<Affine3x4> world(pose.padded());
+        std::vector<Affine3x4> palette(paletteSize, PoseMath::identity());
+        std::vector<uint32_t> cursors;
+        if (clip && geom.hasSkin) {
+            sampleClip(*clip, (float)f / baked.frameRate, pose, cursors);
+            buildPalette(geom, pose, world.data(), palette.data(), false);
+        }
+        Vertex* out = frames.data() + f * vertexCount;
+        for (size_t v = 0; v < vertexCount; v++) skinVertex(source[v], palette.data(), paletteSize, out[v]);
+    });
+
+    VkDeviceSize size = sizeof(Vertex) * frames.size();
+    VkBuffer staging; VkDeviceMemory stagingMem;
+    Memory::createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        staging, stagingMem);
+
+    void* data;
+    vkMapMemory(VK::device, stagingMem, 0, size, 0, &data);
+    memcpy(data, frames.data(), size);
+    vkUnmapMemory(VK::device, stagingMem);
+
+    Memory::createBuffer(size,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, baked.buffer, baked.memory);
+    Memory::copyBuffer(staging, baked.buffer, size);
+
+    vkDestroyBuffer(VK::device, staging, nullptr);
+    vkFreeMemory(VK::device, stagingMem, nullptr);
+
+    Logger::info("SkinnedMesh3D", ("Baked " + (clip ? clip->name : std::string("rest pose")) + ": " +
+                                   std::to_string(baked.frameCount) + " frames, " +
+                                   std::to_string(size / 1024) + " KB").c_str());
+    return geom.bakedClips.emplace(clipIndex, baked).first->second;
 }
 
 void SkinnedMesh3D::updateModelMatrix() {
@@ -676,26 +1256,38 @@ ModelBufferObject SkinnedMesh3D::getModelMatrix() {
     if (isDirty) { updateModelMatrix(); isDirty = false; }
     ModelBufferObject mbo{};
     mbo.model = modelMatrix;
-    mbo.enableNormal = 1;
     mbo.metallic  = metallic;
     mbo.roughness = roughness;
     return mbo;
 }
 
+void SkinnedMesh3D::dispatchSkinning(VkCommandBuffer commandBuffer, int frameIndex) {
+    // throttled or hidden instances keep last frame's skinned vertices
+    if (!(unskinnedFrames & (1u << frameIndex)) || outputRange.count == 0) return;
+
+    SkinningPass::PushConstants params{ outputRange.count, skinnedSharedGeom->sourceRange.offset,
+                                        outputRange.offset, boneRange.offset, boneRange.count };
+    vkCmdPushConstants(commandBuffer, SkinningPass::pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+                       0, sizeof(params), &params);
+    vkCmdDispatch(commandBuffer, (outputRange.count + SkinningPass::GROUP_SIZE - 1) / SkinningPass::GROUP_SIZE, 1, 1);
+
+    unskinnedFrames &= ~(1u << frameIndex);
+}
+
 void SkinnedMesh3D::draw(VkCommandBuffer commandBuffer, VkPipelineLayout layout, int frameIndex) {
-    if (vertexBuffer == VK_NULL_HANDLE || indexBuffer == VK_NULL_HANDLE) return;
+    if (outputRange.count == 0 || indexBuffer == VK_NULL_HANDLE) return;
 
-    // Bind bone SSBO at descriptor set 1
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            layout, 1, 1, &boneDescriptorSets[frameIndex], 0, nullptr);
+    ShaderVariants::bind(materialFeatures);
 
     ModelBufferObject mbo = getModelMatrix();
     vkCmdPushConstants(commandBuffer, layout, VK_SHADER_STAGE_VERTEX_BIT,
                        0, sizeof(ModelBufferObject), &mbo);
 
-    VkBuffer vbs[] = { vertexBuffer };
+    // Every instance lives in the same pooled buffer, so consecutive skinned
+    // draws only differ in vertexOffset
+    VkBuffer vbs[] = { SkinningPass::outputBuffers[frameIndex] };
     VkDeviceSize offsets[] = { 0 };
     vkCmdBindVertexBuffers(commandBuffer, 0, 1, vbs, offsets);
     vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexed(commandBuffer, (uint32_t)m_indices.size(), 1, 0, 0, 0);
+    vkCmdDrawIndexed(commandBuffer, (uint32_t)skinnedSharedGeom->indices.size(), 1, 0, (int32_t)outputRange.offset, 0);
 }
@@ -1,6 +1,8 @@
 #include "Engine/Texture.hpp"
 #include "Engine/Engine.hpp"
 
+#include "Engine/JobSystem.hpp"
+
 #include "stb_image.h"
 
 void Texture::createTextureImageView() {
@@ -8,6 +10,12 @@ void Texture::createTextureImageView() {
 }
 
 void Texture::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) {
+    VkCommandBuffer commandBuffer = Command::beginSingleTimeCommands();
+    recordMipmaps(commandBuffer, image, imageFormat, texWidth, texHeight, mipLevels);
+    Command::endSingleTimeCommands(commandBuffer);
+}
+
+void Texture::recordMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) {
 // Check if image format supports linear blitting
 VkFormatProperties formatProperties;
     vkGetPhysicalDeviceFormatProperties(VK::physicalDevice, imageFormat, &formatProperties);
@@ -16,8 +24,6 @@ VkFormatProperties formatProperties;
         throw std::runtime_error("texture image format does not support linear blitting!");
     }
 
-    VkCommandBuffer commandBuffer = Command::beginSingleTimeCommands();
-
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.image = image;
@@ -90,7 +96,6 @@ VkFormatProperties formatProperties;
         0, nullptr,
         0, nullptr,
         1, &barrier);
-    Command::endSingleTimeCommands(commandBuffer);
 }
 /*
 void Texture::createAssimpTextureImage(aiTexture *tex) {
@@ -125,116 +130,167 @@ void Texture::createAssimpTextureImage(aiTexture *tex) {
 }
 */
 
-void Texture::createFromGLTFImage(const tinygltf::Image& image, VkFormat format) {
-    int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = nullptr;
-    VkDeviceSize imageSize = 0;
-    
-    // Handle different image formats in glTF
-    if (!image.image.empty()) {
-        // Image data is already loaded in the glTF
-        texWidth = image.width;
-        texHeight = image.height;
-        texChannels = image.component;
-        
-        // If image is not RGBA, we need to convert it
-        if (texChannels != 4) {
-            // Use the existing image data but convert to RGBA
-            pixels = stbi_load_from_memory(
-                reinterpret_cast<const stbi_uc*>(image.image.data()),
-                static_cast<int>(image.image.size()),
-                &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-            
-            imageSize = texWidth * texHeight * 4;
-        } else {
-            // Already in RGBA format, just use the data directly
-            pixels = const_cast<stbi_uc*>(image.image.data());
-            imageSize = image.image.size();
+// Per-request scratch for loadBatch
+struct DecodeJob {
+    std::vector<char> file;
+    int width = 0, height = 0;
+    VkDeviceSize offset = 0;
+    bool ok = false;
+};
+
+// Expand a tinygltf-decoded image (1-4 8-bit channels) into RGBA8 at dst
+static void expandToRGBA(const tinygltf::Image& image, unsigned char* dst) {
+    size_t pixelCount = (size_t)image.width * image.height;
+    int c = image.component;
+    if (c == 4) {
+        memcpy(dst, image.image.data(), pixelCount * 4);
+        return;
+    }
+    const unsigned char* src = image.image.data();
+    for (size_t p = 0; p < pixelCount; p++, src += c, dst += 4) {
+        dst[0] = src[0];
+        dst[1] = c > 1 ? src[1] : src[0];
+        dst[2] = c > 2 ? src[2] : src[0];
+        dst[3] = c == 4 ? src[3] : (c == 2 ? src[1] : 255);
+    }
+}
+
+void Texture::loadBatch(std::vector<TextureLoadRequest> &requests) {
+    if (requests.empty()) return;
+    std::vector<DecodeJob> jobs(requests.size());
+
+    // Pass 1 (workers): pull the files out of the zip and read the image headers
+    Jobs::parallelFor(requests.size(), [&](size_t i) {
+        const TextureLoadRequest& req = requests[i];
+        DecodeJob& job = jobs[i];
+        if (req.image) {
+            // tinygltf already decoded embedded images, never decode them again
+            job.ok = !req.image->image.empty() && req.image->bits == 8 && req.image->component >= 1 && req.image->component <= 4;
+            job.width = req.image->width;
+            job.height = req.image->height;
+            return;
         }
-    } else if (!image.uri.empty() && image.uri.find("data:") == 0) {
-        // Handle base64 embedded image data
-        // Extract the base64 data part
-        std::string base64Data = image.uri.substr(image.uri.find(",") + 1);
-        
-        // Decode the base64 string
-        std::vector<unsigned char> decodedData;
-        decodedData.resize(base64Data.size() * 3 / 4); // Approximate size allocation
-        
-        // Use a base64 decoding library here (not shown)
-        // For example: base64_decode(base64Data, decodedData);
-        
-        // Now load the image data
-        pixels = stbi_load_from_memory(
-            decodedData.data(), 
-            static_cast<int>(decodedData.size()),
-            &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-        
-        imageSize = texWidth * texHeight * 4;
-    } else {
-        throw std::runtime_error("Unsupported image format in glTF");
+        job.file = Utils::readFileZip(req.path);
+        int channels;
+        job.ok = !job.file.empty() && stbi_info_from_memory((unsigned char*) job.file.data(), (int) job.file.size(), &job.width, &job.height, &channels);
+    });
+
+    // One staging buffer for the whole batch instead of one allocation per texture
+    VkDeviceSize totalSize = 0;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (!jobs[i].ok) {
+            throw std::runtime_error("failed to load texture image: " + requests[i].path);
+        }
+        jobs[i].offset = totalSize;
+        totalSize += (VkDeviceSize)jobs[i].width * jobs[i].height * 4;
     }
-    
-    // Calculate mip levels
-    mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
-    
-    // Create a staging buffer for the image data
+
     VkBuffer stagingBuffer;
     VkDeviceMemory stagingBufferMemory;
-    Memory::createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-                        stagingBuffer, stagingBufferMemory);
-    
-    // Copy the image data to the staging buffer
-    void* data;
-    vkMapMemory(VK::device, stagingBufferMemory, 0, imageSize, 0, &data);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
+    Memory::createBuffer(totalSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+
+    unsigned char* mapped;
+    vkMapMemory(VK::device, stagingBufferMemory, 0, totalSize, 0, (void**) &mapped);
+
+    // Pass 2 (workers): decode each image into its slice of the mapped staging memory
+    Jobs::parallelFor(requests.size(), [&](size_t i) {
+        const TextureLoadRequest& req = requests[i];
+        DecodeJob& job = jobs[i];
+        unsigned char* dst = mapped + job.offset;
+        if (req.image) {
+            expandToRGBA(*req.image, dst);
+            return;
+        }
+        int w, h, channels;
+        stbi_uc* pixels = stbi_load_from_memory((unsigned char*) job.file.data(), (int) job.file.size(), &w, &h, &channels, STBI_rgb_alpha);
+        job.ok = pixels && w == job.width && h == job.height;
+        // the slice was sized from the header, never copy a different size into it
+        if (job.ok) memcpy(dst, pixels, (size_t)w * h * 4);
+        if (pixels) stbi_image_free(pixels);
+        std::vector<char>().swap(job.file);
+    });
+
     vkUnmapMemory(VK::device, stagingBufferMemory);
-    
-    // Free the pixel data if we allocated it
-    if (texChannels != 4 || !image.uri.empty()) {
-        stbi_image_free(pixels);
+
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (!jobs[i].ok) {
+            vkDestroyBuffer(VK::device, stagingBuffer, nullptr);
+            vkFreeMemory(VK::device, stagingBufferMemory, nullptr);
+            throw std::runtime_error("failed to decode texture image: " + requests[i].path);
+        }
     }
-    
-    // Create the texture image
-    std::string imageName = !image.name.empty() ? image.name : "gltf_texture";
-    Image::createImage(texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, 
-                      format, VK_IMAGE_TILING_OPTIMAL, 
-                      VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 
-                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, imageName.c_str());
-    
-    // Transition image layout and copy data
-    Image::transitionImageLayout(textureImage, format, 
-                               VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
-                               mipLevels);
-    
-    Image::copyBufferToImage(stagingBuffer, textureImage, 
-                           static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-    
-    // Clean up
+
+    // Create all images, then record every copy and mip chain into one command buffer
+    for (size_t i = 0; i < requests.size(); i++) {
+        Texture* tex = requests[i].texture;
+        const DecodeJob& job = jobs[i];
+        tex->mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(job.width, job.height)))) + 1;
+        Image::createImage(job.width, job.height, tex->mipLevels, VK_SAMPLE_COUNT_1_BIT, requests[i].format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, tex->textureImage, tex->textureImageMemory, requests[i].path.c_str());
+    }
+
+    VkCommandBuffer commandBuffer = Command::beginSingleTimeCommands();
+    for (size_t i = 0; i < requests.size(); i++) {
+        Texture* tex = requests[i].texture;
+        const DecodeJob& job = jobs[i];
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = tex->textureImage;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = tex->mipLevels;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = job.offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = { (uint32_t)job.width, (uint32_t)job.height, 1 };
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, tex->textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        //transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL while generating mipmaps
+        recordMipmaps(commandBuffer, tex->textureImage, requests[i].format, job.width, job.height, tex->mipLevels);
+    }
+    Command::endSingleTimeCommands(commandBuffer);
+
     vkDestroyBuffer(VK::device, stagingBuffer, nullptr);
     vkFreeMemory(VK::device, stagingBufferMemory, nullptr);
-    
-    // Generate mipmaps for better texture rendering
-    generateMipmaps(textureImage, format, texWidth, texHeight, mipLevels);
 }
 
-void Texture::createTextureImage(const char *path) {
-    int texWidth, texHeight, texChannels;
-
-    std::vector<char> buffer = std::move(Utils::readFileZip(path));
-
-    //printf("Texture Hash: %s: %s\n", path, hashTexture(buffer.data(), buffer.size()).c_str() );
-    //printf("Path Hash: %s: %s\n", path, hashTexture(path, strlen(path)).c_str() );
+void Texture::createFromGLTFImage(const tinygltf::Image& image, VkFormat format) {
+    if (image.image.empty()) {
+        // tinygltf resolves buffer views and data: URIs itself, anything left is unusable
+        throw std::runtime_error("Unsupported image format in glTF");
+    }
+    std::vector<TextureLoadRequest> requests(1);
+    requests[0].texture = this;
+    requests[0].path = !image.name.empty() ? image.name : "gltf_texture";
+    requests[0].image = &image;
+    requests[0].format = format;
+    loadBatch(requests);
+}
 
-    stbi_uc* pixels = stbi_load_from_memory((unsigned char*) buffer.data(), buffer.size() * sizeof(char), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    
-    VkDeviceSize imageSize = texWidth * texHeight * 4;
+void Texture::createTextureImage(const char *path) {
+    std::vector<TextureLoadRequest> requests(1);
+    requests[0].texture = this;
+    requests[0].path = path;
+    requests[0].format = VK_FORMAT_R8G8B8A8_SRGB;
+    loadBatch(requests);
+}
+void Texture::createFromPixels(const unsigned char *pixels, int texWidth, int texHeight, VkFormat format, uint32_t maxMipLevels, const char *name) {
+    VkDeviceSize imageSize = (VkDeviceSize)texWidth * texHeight * 4;
     mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
-
-    if (!pixels) {
-        printf("Filename: %s\n", path);
-        throw std::runtime_error("failed to load texture image!");
-    }
+    mipLevels = std::max(1u, std::min(mipLevels, maxMipLevels));
 
     VkBuffer stagingBuffer;
     VkDeviceMemory stagingBufferMemory;
@@ -245,18 +301,15 @@ void Texture::createTextureImage(const char *path) {
         memcpy(data, pixels, static_cast<size_t>(imageSize));
     vkUnmapMemory(VK::device, stagingBufferMemory);
 
-    stbi_image_free(pixels);
-
-    Image::createImage(texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_BC3_SRGB_BLOCK, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, path);
+    Image::createImage(texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, name);
 
-    Image::transitionImageLayout(textureImage, VK_FORMAT_BC3_SRGB_BLOCK, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
+    Image::transitionImageLayout(textureImage, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
     Image::copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-    //transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL while generating mipmaps
 
     vkDestroyBuffer(VK::device, stagingBuffer, nullptr);
     vkFreeMemory(VK::device, stagingBufferMemory, nullptr);
 
-    generateMipmaps(textureImage, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, mipLevels);
+    generateMipmaps(textureImage, format, texWidth, texHeight, mipLevels);
 }
 void Texture::destroy() {
     vkDestroyImageView(VK::device, textureImageView, nullptr);
@@ -0,0 +1,239 @@
+#include "Engine/TextureAtlas.hpp"
+#include "Engine/Engine.hpp"
+#include "Engine/JobSystem.hpp"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+// Regions already packed by an earlier model, keyed by texture path, so a
+// second model using the same small texture reuses the existing atlas slot.
+static std::unordered_map<std::string, AtlasRegion> s_regions;
+
+struct AtlasTile {
+    int imageIndex;
+    std::string key;
+    int width, height;
+    std::vector<unsigned char> pixels; // RGBA8
+    int x = 0, y = 0;
+};
+
+static std::string imageKey(const tinygltf::Image& image, const std::string& atlasName, int imageIndex) {
+    if (!image.uri.empty()) return "assets/textures/" + image.uri;
+    return atlasName + "#" + std::to_string(imageIndex);
+}
+
+// True if every TEXCOORD_0 of the primitive lies in [0,1], i.e. the texture
+// isn't tiled and can be squeezed into a sub-rectangle.
+static bool primitiveUVsInRange(const tinygltf::Model& model, const tinygltf::Primitive& prim) {
+    auto it = prim.attributes.find("TEXCOORD_0");
+    if (it == prim.attributes.end()) return true;
+
+    const tinygltf::Accessor& acc = model.accessors[it->second];
+    if (acc.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT) return false;
+    // sparse or zero-filled accessors have no view: not worth atlasing
+    if (acc.bufferView < 0 || acc.bufferView >= (int)model.bufferViews.size()) return false;
+    if (acc.count == 0) return true;
+    const tinygltf::BufferView& bv = model.bufferViews[acc.bufferView];
+    if (bv.buffer < 0 || bv.buffer >= (int)model.buffers.size()) return false;
+    int byteStride = acc.ByteStride(bv);
+    if (byteStride < 0) return false;
+    size_t strideBytes = byteStride > 0 ? (size_t)byteStride : 2 * sizeof(float);
+    // the accessor and its view must lie inside what was actually loaded
+    size_t end = acc.byteOffset + (acc.count - 1) * strideBytes + 2 * sizeof(float);
+    if (end > bv.byteLength || bv.byteOffset + bv.byteLength > model.buffers[bv.buffer].data.size()) return false;
+    const float* uv = reinterpret_cast<const float*>(&model.buffers[bv.buffer].data[bv.byteOffset + acc.byteOffset]);
+    size_t stride = strideBytes / sizeof(float);
+
+    const float eps = 1e-3f;
+    for (size_t v = 0; v < acc.count; v++) {
+        float u = uv[v * stride], w = uv[v * stride + 1];
+        if (u < -eps || u > 1.0f + eps || w < -eps || w > 1.0f + eps) return false;
+    }
+    return true;
+}
+
+static bool decodeTile(const tinygltf::Image& image, AtlasTile& tile) {
+    if (!image.image.empty()) {
+        // tinygltf already decoded embedded images, just expand to RGBA
+        if (image.bits != 8 || image.component < 1 || image.component > 4) return false;
+        if (image.width > ATLAS_MAX_TILE || image.height > ATLAS_MAX_TILE) return false;
+
+        tile.width = image.width;
+        tile.height = image.height;
+        tile.pixels.resize((size_t)tile.width * tile.height * 4);
+        int c = image.component;
+        for (size_t p = 0; p < (size_t)tile.width * tile.height; p++) {
+            const unsigned char* src = &image.image[p * c];
+            unsigned char* dst = &tile.pixels[p * 4];
+            dst[0] = src[0];
+            dst[1] = c > 1 ? src[1] : src[0];
+            dst[2] = c > 2 ? src[2] : src[0];
+            dst[3] = c == 4 ? src[3] : (c == 2 ? src[1] : 255);
+        }
+        return true;
+    }
+
+    if (image.uri.empty() || !Utils::fileExistsZip(tile.key)) return false;
+
+    std::vector<char> buffer = Utils::readFileZip(tile.key);
+    int w, h, channels;
+    // check the header first so big textures are never fully decoded twice
+    if (!stbi_info_from_memory((unsigned char*) buffer.data(), buffer.size(), &w, &h, &channels)) return false;
+    if (w > ATLAS_MAX_TILE || h > ATLAS_MAX_TILE) return false;
+
+    stbi_uc* pixels = stbi_load_from_memory((unsigned char*) buffer.data(), buffer.size(), &w, &h, &channels, STBI_rgb_alpha);
+    if (!pixels) return false;
+
+    tile.width = w;
+    tile.height = h;
+    tile.pixels.assign(pixels, pixels + (size_t)w * h * 4);
+    stbi_image_free(pixels);
+    return true;
+}
+
+// Simple shelf packer: tallest first, left to right, new shelf when the row is full.
+// Returns the used height, or -1 if the tiles don't fit in one page.
+static int packShelves(std::vector<AtlasTile>& tiles, int pageWidth) {
+    std::sort(tiles.begin(), tiles.end(), [](const AtlasTile& a, const AtlasTile& b) {
+        return a.height > b.height;
+    });
+
+    int x = 0, y = 0, shelfHeight = 0;
+    for (auto& tile : tiles) {
+        int w = tile.width + ATLAS_PADDING * 2;
+        int h = tile.height + ATLAS_PADDING * 2;
+        if (x + w > pageWidth) {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+        tile.x = x;
+        tile.y = y;
+        x += w;
+        shelfHeight = std::max(shelfHeight, h);
+    }
+    y += shelfHeight;
+    return y <= ATLAS_SIZE ? y : -1;
+}
+
+static void blitTile(std::vector<unsigned char>& page, int pageWidth, const AtlasTile& tile) {
+    // copy with clamp-to-edge into the padded rectangle
+    int w = tile.width + ATLAS_PADDING * 2;
+    int h = tile.height + ATLAS_PADDING * 2;
+    for (int py = 0; py < h; py++) {
+        int sy = std::clamp(py - ATLAS_PADDING, 0, tile.height - 1);
+        for (int px = 0; px < w; px++) {
+            int sx = std::clamp(px - ATLAS_PADDING, 0, tile.width - 1);
+            memcpy(&page[((size_t)(tile.y + py) * pageWidth + tile.x + px) * 4],
+                   &tile.pixels[((size_t)sy * tile.width + sx) * 4], 4);
+        }
+    }
+}
+
+std::unordered_map<int, AtlasRegion> TextureAtlas::packModel(const tinygltf::Model& model, const std::string& atlasName) {
+    std::unordered_map<int, AtlasRegion> result;
+
+    // images used as normal / metallic-roughness maps need a linear format and stay standalone
+    std::unordered_set<int> excluded;
+    for (const auto& mat : model.materials) {
+        for (int texIndex : { mat.normalTexture.index, mat.pbrMetallicRoughness.metallicRoughnessTexture.index }) {
+            if (texIndex >= 0 && texIndex < (int)model.textures.size()) excluded.insert(model.textures[texIndex].source);
+        }
+    }
+
+    // base colour images whose UVs stay in [0,1] for every primitive using them
+    std::unordered_map<int, bool> candidates;
+    for (const auto& mesh : model.meshes) {
+        for (const auto& prim : mesh.primitives) {
+            if (prim.material < 0 || prim.material >= (int)model.materials.size()) continue;
+            const auto& colorTex = model.materials[prim.material].pbrMetallicRoughness.baseColorTexture;
+            if (colorTex.index < 0 || colorTex.index >= (int)model.textures.size()) continue;
+
+            int source = model.textures[colorTex.index].source;
+            if (source < 0 || source >= (int)model.images.size()) continue;
+
+            bool usable = colorTex.texCoord == 0 && primitiveUVsInRange(model, prim);
+            auto it = candidates.find(source);
+            candidates[source] = (it == candidates.end() ? true : it->second) && usable;
+        }
+    }
+
+    std::vector<AtlasTile> tiles;
+    for (const auto& [imageIndex, usable] : candidates) {
+        if (!usable || excluded.count(imageIndex)) continue;
+
+        AtlasTile tile;
+        tile.imageIndex = imageIndex;
+        tile.key = imageKey(model.images[imageIndex], atlasName, imageIndex);
+
+        // packed by an earlier model
+        auto cached = s_regions.find(tile.key);
+        if (cached != s_regions.end()) {
+            result[imageIndex] = cached->second;
+            continue;
+        }
+        // already loaded standalone by an earlier model, keep using that
+        if (std::find(VK::g_texturePathList.begin(), VK::g_texturePathList.end(), tile.key) != VK::g_texturePathList.end()) continue;
+
+        tiles.push_back(std::move(tile));
+    }
+
+    // decode on the job pool, drop whatever turned out too big or unreadable
+    std::vector<char> decoded(tiles.size(), 0);
+    Jobs::parallelFor(tiles.size(), [&](size_t i) {
+        decoded[i] = decodeTile(model.images[tiles[i].imageIndex], tiles[i]);
+    });
+    size_t kept = 0;
+    for (size_t i = 0; i < tiles.size(); i++) {
+        if (!decoded[i]) continue;
+        if (kept != i) tiles[kept] = std::move(tiles[i]);
+        kept++;
+    }
+    tiles.resize(kept);
+
+    // one small texture gains nothing from an atlas
+    if (tiles.size() < 2) return result;
+
+    int pageWidth = std::min(ATLAS_SIZE, ATLAS_MAX_TILE * 4);
+    int pageHeight = packShelves(tiles, pageWidth);
+    if (pageHeight < 0) {
+        pageWidth = ATLAS_SIZE;
+        pageHeight = packShelves(tiles, pageWidth);
+    }
+    if (pageHeight < 0) {
+        Logger::warning("TextureAtlas", ("Too many small textures to pack for " + atlasName).c_str());
+        return result;
+    }
+
+    std::vector<unsigned char> page((size_t)pageWidth * pageHeight * 4, 0);
+    for (const auto& tile : tiles) blitTile(page, pageWidth, tile);
+
+    std::string atlasPath = "atlas/" + atlasName;
+    int atlasID = (int)VK::g_texturePathList.size();
+
+    Texture texture;
+    texture.textureID = atlasID;
+    // mips past log2(padding) would start mixing tiles together
+    uint32_t maxMips = (uint32_t)std::log2(ATLAS_PADDING) + 1;
+    texture.createFromPixels(page.data(), pageWidth, pageHeight, VK_FORMAT_R8G8B8A8_SRGB, maxMips, atlasPath.c_str());
+    texture.createTextureImageView();
+
+    VK::textureMap[atlasPath] = texture;
+    VK::g_texturePathList.push_back(atlasPath);
+
+    for (const auto& tile : tiles) {
+        AtlasRegion region;
+        region.textureID = atlasID;
+        region.offset = glm::vec2(tile.x + ATLAS_PADDING, tile.y + ATLAS_PADDING) / glm::vec2(pageWidth, pageHeight);
+        region.scale = glm::vec2(tile.width, tile.height) / glm::vec2(pageWidth, pageHeight);
+        result[tile.imageIndex] = region;
+        s_regions[tile.key] = region;
+    }
+
+    Logger::info("TextureAtlas", ("Packed " + std::to_string(tiles.size()) + " textures into " + atlasPath + " (" +
+        std::to_string(pageWidth) + "x" + std::to_string(pageHeight) + ")").c_str());
+    return result;
+}
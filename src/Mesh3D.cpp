@@ -1,6 +1,9 @@
 #include "Engine/Mesh3D.hpp"
 #include "Engine/Engine.hpp"
 #include "Engine/Vertex.hpp"
+#include "Engine/ShapeCache.hpp"
+#include "Engine/BodyPool.hpp"
+#include "VK/ShaderVariants.hpp"
 #include "config.h"
 
 #include <string.h>
@@ -20,6 +23,8 @@ void Mesh3D::init(const char *modelName) {
 }
 
 void Mesh3D::destroy() {
+    destroyRigidBody();
+
     if (sharedGeom) {
         sharedGeom->refCount--;
         if (sharedGeom->refCount <= 0) {
@@ -105,6 +110,9 @@ void Mesh3D::draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout
     if (vertexBuffer == VK_NULL_HANDLE || indexBuffer == VK_NULL_HANDLE) {
         return;
     }
+    // switch to this mesh's pipeline variant (no-op outside the main pass)
+    ShaderVariants::bind(materialFeatures);
+
     // update mesh push constants
     updatePushConstants(commandBuffer, pipelineLayout);
 
@@ -129,6 +137,7 @@ void Mesh3D::loadModel(const char* filename) {
         AA           = sharedGeom->AA;
         BB           = sharedGeom->BB;
         modelCenter  = sharedGeom->modelCenter;
+        materialFeatures   = sharedGeom->materialFeatures;
         vertexBuffer       = sharedGeom->vertexBuffer;
         vertexBufferMemory = sharedGeom->vertexBufferMemory;
         indexBuffer        = sharedGeom->indexBuffer;
@@ -144,12 +153,14 @@ void Mesh3D::loadModel(const char* filename) {
         AA          = sharedGeom->AA;
         BB          = sharedGeom->BB;
         modelCenter = sharedGeom->modelCenter;
+        materialFeatures = ShaderVariants::featuresFromVertices(m_vertices);
         createVertexBuffer();
         createIndexBuffer();
         sharedGeom->vertexBuffer       = vertexBuffer;
         sharedGeom->vertexBufferMemory = vertexBufferMemory;
         sharedGeom->indexBuffer        = indexBuffer;
         sharedGeom->indexBufferMemory  = indexBufferMemory;
+        sharedGeom->materialFeatures   = materialFeatures;
         s_cache[filename] = sharedGeom;
     }
     updateModelMatrix();
@@ -171,8 +182,6 @@ ModelBufferObject Mesh3D::getModelMatrix() {
     ModelBufferObject ubo{};
     ubo.model = modelMatrix;
 
-    // shader toggles
-    ubo.enableNormal = Engine::enableNormal;
     ubo.metallic = metallic;
     ubo.roughness = roughness;
     // return the matrix to the GPU via push constants
@@ -188,76 +197,37 @@ void Mesh3D::updatePushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout
 void Mesh3D::createRigidBody(float mass, ColliderType colliderType) {
     glm::vec3 size = glm::vec3(abs(BB.x - AA.x), abs(BB.y - AA.y), abs(BB.z - AA.z));
 
-    btCollisionShape *collisionShape = nullptr;
-
     hasPhysics = true;
 
-    if (colliderType == ColliderType::BOX) {
-        collisionShape = new btCompoundShape();
-        btBoxShape *child = new btBoxShape(btVector3(size.x / 2.0, size.y / 2.0, size.z / 2.0));
-
-        glm::vec3 vertCenter = -modelCenter;
-        btTransform localTransform;
-        localTransform.setIdentity();
-        //localTransform.setOrigin(btVector3(vertCenter.x, vertCenter.y, vertCenter.z));
-        ((btCompoundShape*)collisionShape)->addChildShape(localTransform, child);
-    } else if (colliderType == ColliderType::CONVEXHULL) {
-        collisionShape = new btConvexHullShape();
-        float triangleCount = m_indices.size() / 3;
-
-        // 33% of vertices: optimization, triangulated mesh, every 3 vertices are close, so only use every third vertex
-        // double 3 to 6 because we skip every other triangle,
-        // since they are often right next to eachother and can be removed from the convex hull
-
-        for (int i = 0; i < m_indices.size(); i += 6) {
-            glm::vec3 pnt = m_vertices[m_indices[ i ]].pos;
-            ((btConvexHullShape *)collisionShape)->addPoint(btVector3(pnt.x, pnt.y, pnt.z), true);
-        }
-        ((btConvexHullShape *)collisionShape)->optimizeConvexHull();
-    } else { // static triangle mesh
-        btTriangleMesh *mesh = new btTriangleMesh();
-        for (int i = 0; i < m_indices.size(); i += 3) {
-            glm::vec3 pntA = m_vertices[m_indices[ i ]].pos;
-            glm::vec3 pntB = m_vertices[m_indices[ i+1 ]].pos;
-            glm::vec3 pntC = m_vertices[m_indices[ i+2 ]].pos;
-
-            mesh->addTriangle(
-                btVector3(pntA.x, pntA.y, pntA.z),
-                btVector3(pntB.x, pntB.y, pntB.z),
-                btVector3(pntC.x, pntC.y, pntC.z)
-            );
-            mesh->addTriangleIndices(0, 1, 2);
-        }
-        collisionShape = new btBvhTriangleMeshShape(mesh, true);
-
-    }
+    // shared with every instance of this model at this scale
+    btCollisionShape *collisionShape = ShapeCache::get(fileName, colliderType, m_vertices, m_indices, size, scale);
 
     btTransform bodyTransform;
     bodyTransform.setIdentity();
     bodyTransform.setOrigin(btVector3(position.x, position.y, position.z));
     bodyTransform.setRotation(btQuaternion(orientation.x, orientation.y, orientation.z, orientation.w));
 
-    collisionShape->setLocalScaling(btVector3(scale.x, scale.y, scale.z));
-
     btVector3 localInertia(0, 0, 0);
     if (mass != 0.0) {
         collisionShape->calculateLocalInertia(mass, localInertia);
     }
 
-    btDefaultMotionState* motionState = new btDefaultMotionState(bodyTransform);
-
-    collisionShape->setMargin(0.001);
+    rigidBody = Physics::BodyPool::create(mass, collisionShape, bodyTransform, localInertia);
+    rigidBody->setSleepingThresholds(PHYSICS_SLEEP_LINEAR, PHYSICS_SLEEP_ANGULAR);
+    Physics::applyActivationPolicy(rigidBody, activationPolicy);
+}
 
-    rigidBody = new btRigidBody(
-        btRigidBody::btRigidBodyConstructionInfo(
-            mass, motionState, collisionShape, localInertia
-        )
-    );
+void Mesh3D::destroyRigidBody() {
+    if (!hasPhysics) return;
+    Physics::BodyPool::destroy(rigidBody);
+    rigidBody = nullptr;
+    hasPhysics = false;
 }
 
 void Mesh3D::loadRaw(std::vector<Vertex> &m_vertices, std::vector<uint32_t> &m_indices, const char *name) {
     this->m_vertices = m_vertices;
     this->m_indices = m_indices;
+    materialFeatures = ShaderVariants::featuresFromVertices(this->m_vertices);
     updateModelMatrix();
 
     this->fileName = name;
@@ -269,16 +239,60 @@ void Mesh3D::loadRaw(std::vector<Vertex> &m_vertices, std::vector<uint32_t> &m_i
 }
 
 void Mesh3D::setLinearVelocity(glm::vec3 velocity) {
-    if (hasPhysics)
-        rigidBody->setLinearVelocity(worldToPhysics(velocity));
+    if (!hasPhysics) return;
+    btRigidBody* body = rigidBody;
+    btVector3 v = worldToPhysics(velocity);
+    Physics::enqueue(body, [body, v] {
+        body->activate();
+        body->setLinearVelocity(v);
+    });
 }
 
 glm::vec3 Mesh3D::getLinearVelocity() const {
     if (!hasPhysics) return glm::vec3(0.0f);
-    return physicsToWorld(rigidBody->getLinearVelocity());
+    const Physics::BodyState* state = Physics::state(rigidBody);
+    return state ? state->linearVelocity : glm::vec3(0.0f);
 }
 
 glm::vec3 Mesh3D::getPhysicsPosition() const {
     if (!hasPhysics) return position;
-    return physicsToWorld(rigidBody->getInterpolationWorldTransform().getOrigin());
+    const Physics::BodyState* state = Physics::state(rigidBody);
+    return state ? state->position : position;
+}
+
+void Mesh3D::setFriction(float f) {
+    if (!hasPhysics) return;
+    btRigidBody* body = rigidBody;
+    Physics::enqueue(body, [body, f] { body->setFriction(f); });
+}
+
+void Mesh3D::setRestitution(float r) {
+    if (!hasPhysics) return;
+    btRigidBody* body = rigidBody;
+    Physics::enqueue(body, [body, r] { body->setRestitution(r); });
+}
+
+void Mesh3D::setDamping(float linear, float angular) {
+    if (!hasPhysics) return;
+    btRigidBody* body = rigidBody;
+    Physics::enqueue(body, [body, linear, angular] { body->setDamping(linear, angular); });
+}
+
+void Mesh3D::setActivationPolicy(ActivationPolicy policy) {
+    activationPolicy = policy;
+    if (!hasPhysics) return;
+    btRigidBody* body = rigidBody;
+    Physics::enqueue(body, [body, policy] { Physics::applyActivationPolicy(body, policy); });
+}
+
+void Mesh3D::wake() {
+    if (!hasPhysics) return;
+    btRigidBody* body = rigidBody;
+    Physics::enqueue(body, [body] { body->activate(); });
+}
+
+bool Mesh3D::isSleeping() const {
+    if (!hasPhysics) return false;
+    const Physics::BodyState* state = Physics::state(rigidBody);
+    return state && state->sleeping;
 }
\ No newline at end of file
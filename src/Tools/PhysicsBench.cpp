@@ -0,0 +1,92 @@
+// Headless physics benchmark: drops a pile of bodies onto a floor and times
+// fixed steps of the same world PhysicsManager builds, once per scheduler
+// thread count, printing the speedup over one thread.
+//
+//   vorpal_physics_bench [bodies=800] [steps=600]
+//
+// Only built with VORPAL_PHYSICS_MT; every run starts from the same state.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Engine/PhysicsWorld.hpp"
+
+static double runScene(int bodyCount, int steps) {
+    Physics::World world;
+    world.create();
+
+    btStaticPlaneShape floorShape(btVector3(0, 1, 0), 0);
+    btBoxShape boxShape(btVector3(0.25f, 0.25f, 0.25f));
+    btSphereShape sphereShape(0.25f);
+    btCapsuleShape capsuleShape(0.2f, 0.4f);
+    btCollisionShape *shapes[] = { &boxShape, &sphereShape, &capsuleShape };
+
+    std::vector<btDefaultMotionState> motionStates;
+    std::vector<btRigidBody *> bodies;
+    motionStates.reserve(bodyCount + 1);
+    bodies.reserve(bodyCount + 1);
+
+    btTransform transform;
+    transform.setIdentity();
+    motionStates.emplace_back(transform);
+    bodies.push_back(new btRigidBody(0.0f, &motionStates.back(), &floorShape));
+
+    // columns of mixed shapes, close enough to form one big contact pile
+    int side = 1;
+    while (side * side * 8 < bodyCount) side++;
+    for (int i = 0; i < bodyCount; i++) {
+        int column = i % (side * side);
+        int layer = i / (side * side);
+        transform.setOrigin(btVector3(
+            (column % side - side * 0.5f) * 0.55f,
+            0.5f + layer * 0.6f,
+            (column / side - side * 0.5f) * 0.55f
+        ));
+
+        btCollisionShape *shape = shapes[i % 3];
+        btVector3 inertia(0, 0, 0);
+        shape->calculateLocalInertia(1.0f, inertia);
+        motionStates.emplace_back(transform);
+        bodies.push_back(new btRigidBody(1.0f, &motionStates.back(), shape, inertia));
+    }
+    for (btRigidBody *body : bodies) world.dynamicsWorld->addRigidBody(body);
+
+    const float fixed = 1.0f / PHYSICS_HZ;
+    // settle the first impacts before timing
+    for (int i = 0; i < 30; i++) world.dynamicsWorld->stepSimulation(fixed, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < steps; i++) world.dynamicsWorld->stepSimulation(fixed, 0);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    for (btRigidBody *body : bodies) {
+        world.dynamicsWorld->removeRigidBody(body);
+        delete body;
+    }
+    return ms / steps;
+}
+
+int main(int argc, char **argv) {
+    int bodyCount = argc > 1 ? std::atoi(argv[1]) : 800;
+    int steps = argc > 2 ? std::atoi(argv[2]) : 600;
+
+    Physics::setThreadCount(1);
+    int maxThreads = btGetTaskScheduler()->getMaxNumThreads();
+    int available = Physics::defaultThreadCount() + 1;
+    if (available < maxThreads) maxThreads = available;
+
+    printf("%d bodies, %d steps at %.0f Hz, scheduler: %s\n",
+           bodyCount, steps, PHYSICS_HZ, btGetTaskScheduler()->getName());
+    printf("threads   ms/step   speedup\n");
+
+    double baseline = 0.0;
+    for (int threads = 1; threads <= maxThreads; threads++) {
+        Physics::setThreadCount(threads);
+        double ms = runScene(bodyCount, steps);
+        if (threads == 1) baseline = ms;
+        printf("%7d %9.3f %8.2fx\n", threads, ms, baseline / ms);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+// Headless texture decode benchmark: reads and decodes a set of images the
+// way texture loading worked before the job pool (one file after another,
+// each decoded into its own allocation and copied into its own staging
+// memory) and the way Texture::loadBatch does it now (read and decode on
+// every core, straight into slices of one preallocated buffer), printing
+// the speedup.
+//
+//   vorpal_texture_bench [repeat=4] image...
+//
+// Every image is loaded `repeat` times per run, standing in for a level
+// with that many textures. Only the CPU side is timed, not the upload.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "Engine/JobSystem.hpp"
+
+static std::vector<char> readFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static double now() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// One texture at a time, a fresh staging allocation each
+static double runSerial(const std::vector<std::string> &paths) {
+    double start = now();
+    for (const std::string &path : paths) {
+        std::vector<char> file = readFile(path);
+        int w, h, channels;
+        stbi_uc *pixels = stbi_load_from_memory((unsigned char *)file.data(), (int)file.size(), &w, &h, &channels, STBI_rgb_alpha);
+        if (!pixels) {
+            fprintf(stderr, "failed to decode %s\n", path.c_str());
+            exit(EXIT_FAILURE);
+        }
+        std::vector<unsigned char> staging((size_t)w * h * 4);
+        memcpy(staging.data(), pixels, staging.size());
+        stbi_image_free(pixels);
+    }
+    return now() - start;
+}
+
+// As loadBatch: read and size every image in parallel, one buffer for the
+// batch, then decode in parallel into its slices
+static double runBatched(const std::vector<std::string> &paths) {
+    struct Job {
+        std::vector<char> file;
+        int width = 0, height = 0;
+        size_t offset = 0;
+    };
+    double start = now();
+
+    std::vector<Job> jobs(paths.size());
+    Jobs::parallelFor(paths.size(), [&](size_t i) {
+        jobs[i].file = readFile(paths[i]);
+        int channels;
+        stbi_info_from_memory((unsigned char *)jobs[i].file.data(), (int)jobs[i].file.size(), &jobs[i].width, &jobs[i].height, &channels);
+    });
+
+    size_t total = 0;
+    for (Job &job : jobs) {
+        job.offset = total;
+        total += (size_t)job.width * job.height * 4;
+    }
+    std::vector<unsigned char> staging(total);
+
+    Jobs::parallelFor(paths.size(), [&](size_t i) {
+        Job &job = jobs[i];
+        int w, h, channels;
+        stbi_uc *pixels = stbi_load_from_memory((unsigned char *)job.file.data(), (int)job.file.size(), &w, &h, &channels, STBI_rgb_alpha);
+        if (pixels) {
+            memcpy(staging.data() + job.offset, pixels, (size_t)w * h * 4);
+            stbi_image_free(pixels);
+        }
+        std::vector<char>().swap(job.file);
+    });
+    return now() - start;
+}
+
+int main(int argc, char **argv) {
+    int first = 1;
+    int repeat = 4;
+    if (argc > 1 && argv[1][0] >= '0' && argv[1][0] <= '9') {
+        repeat = std::atoi(argv[1]);
+        first = 2;
+    }
+    if (first >= argc) {
+        fprintf(stderr, "usage: %s [repeat=4] image...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> paths;
+    for (int r = 0; r < repeat; r++) {
+        for (int i = first; i < argc; i++) paths.push_back(argv[i]);
+    }
+
+    // warm the file cache and the pool
+    runSerial(paths);
+    runBatched(paths);
+
+    const int runs = 5;
+    double serial = 0.0, batched = 0.0;
+    for (int i = 0; i < runs; i++) {
+        serial += runSerial(paths);
+        batched += runBatched(paths);
+    }
+    serial /= runs;
+    batched /= runs;
+
+    printf("%zu textures, %u threads\n", paths.size(), Jobs::threadCount());
+    printf("serial    %9.2f ms\n", serial);
+    printf("batched   %9.2f ms  %.2fx\n", batched, serial / batched);
+    return EXIT_SUCCESS;
+}
@@ -59,6 +59,9 @@ void loop(double deltaTime) {
 
     // user input
     renderer.handle_input();
+
+    // physics runs on its own fixed clock, after input set this frame's velocities
+    renderer.update_physics();
 }
 void cleanup() {
     renderer.cleanup();